@@ -0,0 +1,438 @@
+///  Contains the graph query server implementation
+#include "GraphServer.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using std::min;
+using std::stable_sort;
+using std::unique_lock;
+
+//  Limits of one connection: requests queued for workers and bytes of responses not sent yet
+static const size_t MAX_IN_FLIGHT = 1024;
+static const size_t MAX_OUTPUT_BACKLOG = 1 << 20;
+
+static bool SetNonBlocking(int fd)
+{
+	int flags = fcntl(fd, F_GETFL, 0);
+	return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+GraphServer::GraphServer(const Graph &G, const HubLabels *pLabels, unsigned int threadsAmount, unsigned int batchSize, size_t cacheBytes) :
+	m_Graph(G), m_pLabels(pLabels), m_MSTLength(0.0), m_ThreadsAmount(threadsAmount > 0 ? threadsAmount : 1),
+	m_BatchSize(batchSize > 0 ? batchSize : 1), m_CacheBytes(cacheBytes), m_ListenSocket(-1), m_Epoll(-1), m_WakeUp(-1), m_bStopping(false), m_bJobsClosed(false)
+{
+	//  Lazy parts of the Graph are built before workers share it
+	m_Graph.BuildCaches(m_ThreadsAmount);
+	m_Graph.PrimMST(m_MSTLength);
+}
+
+GraphServer::~GraphServer()
+{
+	for (auto it = m_Connections.begin(); it != m_Connections.end(); ++it)
+		close(it->first);
+	if (m_ListenSocket >= 0)
+		close(m_ListenSocket);
+	if (m_Epoll >= 0)
+		close(m_Epoll);
+	if (m_WakeUp >= 0)
+		close(m_WakeUp);
+}
+
+bool GraphServer::Listen(const string &socketPath)
+{
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (socketPath.size() >= sizeof(address.sun_path))
+		return false;
+	strcpy(address.sun_path, socketPath.c_str());
+	unlink(socketPath.c_str());
+
+	m_ListenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (m_ListenSocket < 0 || !SetNonBlocking(m_ListenSocket) ||
+		bind(m_ListenSocket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(m_ListenSocket, SOMAXCONN) != 0)
+		return false;
+
+	m_Epoll = epoll_create1(0);
+	m_WakeUp = eventfd(0, EFD_NONBLOCK);
+	if (m_Epoll < 0 || m_WakeUp < 0)
+		return false;
+
+	epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = m_ListenSocket;
+	if (epoll_ctl(m_Epoll, EPOLL_CTL_ADD, m_ListenSocket, &event) != 0)
+		return false;
+	event.data.fd = m_WakeUp;
+	return epoll_ctl(m_Epoll, EPOLL_CTL_ADD, m_WakeUp, &event) == 0;
+}
+
+void GraphServer::Run()
+{
+	vector<thread> workers;
+	for (unsigned int i = 0; i < m_ThreadsAmount; ++i)
+		workers.push_back(thread(&GraphServer::WorkerLoop, this));
+
+	const int maxEvents = 64;
+	epoll_event events[maxEvents];
+	while (!m_bStopping)
+	{
+		int amount = epoll_wait(m_Epoll, events, maxEvents, -1);
+		if (amount < 0 && errno != EINTR)
+			break;
+
+		for (int i = 0; i < amount; ++i)
+		{
+			int fd = events[i].data.fd;
+			if (fd == m_ListenSocket)
+				AcceptConnections();
+			else if (fd == m_WakeUp)
+			{
+				uint64_t value;
+				while (read(m_WakeUp, &value, sizeof(value)) > 0)
+					;
+				WriteReadyConnections();
+			}
+			else
+			{
+				auto it = m_Connections.find(fd);
+				if (it == m_Connections.end())
+					continue;
+				//  the connection is held here because closing it removes it from the map
+				shared_ptr<Connection> connection = it->second;
+				if (events[i].events & (EPOLLERR | EPOLLHUP))
+					CloseConnection(connection);
+				else
+				{
+					if (events[i].events & EPOLLOUT)
+						WriteResponses(connection);
+					//  writing may close the connection (its socket number can't be read after that)
+					if ((events[i].events & EPOLLIN) && m_Connections.count(fd) > 0)
+						ReadRequests(connection);
+				}
+			}
+		}
+	}
+
+	{
+		unique_lock<mutex> lock(m_JobsMutex);
+		m_bJobsClosed = true;
+	}
+	m_JobsReady.notify_all();
+	for (auto it = workers.begin(); it != workers.end(); ++it)
+		it->join();
+}
+
+void GraphServer::Stop()
+{
+	m_bStopping = true;
+	uint64_t value = 1;
+	if (write(m_WakeUp, &value, sizeof(value)) < 0)
+		return;
+}
+
+void GraphServer::AcceptConnections()
+{
+	while (true)
+	{
+		int socket = accept(m_ListenSocket, NULL, NULL);
+		if (socket < 0)
+			return;
+
+		epoll_event event;
+		memset(&event, 0, sizeof(event));
+		event.events = EPOLLIN;
+		event.data.fd = socket;
+		if (!SetNonBlocking(socket) || epoll_ctl(m_Epoll, EPOLL_CTL_ADD, socket, &event) != 0)
+		{
+			close(socket);
+			continue;
+		}
+		shared_ptr<Connection> connection(new Connection(socket));
+		connection->m_Events = EPOLLIN;
+		m_Connections[socket] = connection;
+	}
+}
+
+//  The socket is read only until the allowed amount of requests is there, the rest waits in the socket buffer.
+//  All the complete requests read at once are queued under one lock
+void GraphServer::ReadRequests(const shared_ptr<Connection> &connection)
+{
+	size_t allowed = GetAllowedRequests(connection);
+	char buffer[65536];
+	while (connection->m_Input.size() < allowed * sizeof(RequestHeader))
+	{
+		ssize_t size = recv(connection->m_Socket, buffer, sizeof(buffer), 0);
+		if (size > 0)
+		{
+			connection->m_Input.insert(connection->m_Input.end(), buffer, buffer + size);
+			continue;
+		}
+		if (size == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+		{
+			CloseConnection(connection);
+			return;
+		}
+		if (errno != EINTR)
+			break;
+	}
+
+	size_t amount = min(allowed, connection->m_Input.size() / sizeof(RequestHeader));
+	if (amount == 0)
+	{
+		UpdateEvents(connection);
+		return;
+	}
+
+	//  counted before workers can see the jobs so they never decrement it first
+	{
+		unique_lock<mutex> lock(connection->m_Mutex);
+		connection->m_InFlight += amount;
+	}
+	{
+		unique_lock<mutex> lock(m_JobsMutex);
+		for (size_t i = 0; i < amount; ++i)
+		{
+			Job job;
+			job.m_Connection = connection;
+			memcpy(&job.m_Request, &connection->m_Input[i * sizeof(RequestHeader)], sizeof(RequestHeader));
+			m_Jobs.push_back(job);
+		}
+	}
+	m_JobsReady.notify_all();
+	connection->m_Input.erase(connection->m_Input.begin(), connection->m_Input.begin() + amount * sizeof(RequestHeader));
+	UpdateEvents(connection);
+}
+
+//  Send as much as the socket takes. If something is left wait until the socket is writable again.
+//  If reading was paused and the connection is under its limits again reading is resumed: requests left
+//  in the input are queued and the socket is read
+void GraphServer::WriteResponses(const shared_ptr<Connection> &connection)
+{
+	bool bError = false;
+	{
+		unique_lock<mutex> lock(connection->m_Mutex);
+		if (connection->m_bClosed)
+			return;
+
+		while (connection->m_OutputSent < connection->m_Output.size())
+		{
+			ssize_t size = send(connection->m_Socket, &connection->m_Output[connection->m_OutputSent],
+				connection->m_Output.size() - connection->m_OutputSent, MSG_NOSIGNAL);
+			if (size > 0)
+				connection->m_OutputSent += size;
+			else if (size < 0 && errno == EINTR)
+				continue;
+			else
+			{
+				bError = size == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+				break;
+			}
+		}
+
+		if (connection->m_OutputSent == connection->m_Output.size())
+		{
+			connection->m_Output.resize(0);
+			connection->m_OutputSent = 0;
+		}
+	}
+
+	if (bError)
+	{
+		CloseConnection(connection);
+		return;
+	}
+
+	if ((connection->m_Events & EPOLLIN) == 0 && GetAllowedRequests(connection) > 0)
+		ReadRequests(connection);
+	else
+		UpdateEvents(connection);
+}
+
+size_t GraphServer::GetAllowedRequests(const shared_ptr<Connection> &connection) const
+{
+	unique_lock<mutex> lock(connection->m_Mutex);
+	if (connection->m_Output.size() - connection->m_OutputSent >= MAX_OUTPUT_BACKLOG || connection->m_InFlight >= MAX_IN_FLIGHT)
+		return 0;
+	return MAX_IN_FLIGHT - connection->m_InFlight;
+}
+
+void GraphServer::UpdateEvents(const shared_ptr<Connection> &connection)
+{
+	bool bPending;
+	{
+		unique_lock<mutex> lock(connection->m_Mutex);
+		bPending = connection->m_OutputSent < connection->m_Output.size();
+	}
+	unsigned int events = (GetAllowedRequests(connection) > 0 ? static_cast<unsigned int>(EPOLLIN) : 0u) |
+		(bPending ? static_cast<unsigned int>(EPOLLOUT) : 0u);
+	if (events == connection->m_Events)
+		return;
+
+	epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = events;
+	event.data.fd = connection->m_Socket;
+	epoll_ctl(m_Epoll, EPOLL_CTL_MOD, connection->m_Socket, &event);
+	connection->m_Events = events;
+}
+
+//  Workers may still hold the connection, they see m_bClosed and their responses are dropped
+void GraphServer::CloseConnection(const shared_ptr<Connection> &connection)
+{
+	{
+		unique_lock<mutex> lock(connection->m_Mutex);
+		if (connection->m_bClosed)
+			return;
+		connection->m_bClosed = true;
+	}
+	epoll_ctl(m_Epoll, EPOLL_CTL_DEL, connection->m_Socket, NULL);
+	close(connection->m_Socket);
+	m_Connections.erase(connection->m_Socket);
+}
+
+void GraphServer::WriteReadyConnections()
+{
+	vector<shared_ptr<Connection>> ready;
+	{
+		unique_lock<mutex> lock(m_ReadyMutex);
+		ready.swap(m_Ready);
+	}
+	for (auto it = ready.begin(); it != ready.end(); ++it)
+		WriteResponses(*it);
+}
+
+void GraphServer::WorkerLoop()
+{
+	ShortestPathAlgorithm spa;
+	spa.SetCacheLimit(m_CacheBytes);
+	vector<Job> batch;
+	vector<char> output;
+	while (true)
+	{
+		batch.resize(0);
+		{
+			unique_lock<mutex> lock(m_JobsMutex);
+			while (m_Jobs.empty() && !m_bJobsClosed)
+				m_JobsReady.wait(lock);
+			if (m_Jobs.empty())
+				return;
+
+			size_t amount = min<size_t>(m_BatchSize, m_Jobs.size());
+			batch.assign(m_Jobs.begin(), m_Jobs.begin() + amount);
+			m_Jobs.erase(m_Jobs.begin(), m_Jobs.begin() + amount);
+		}
+
+		//  Requests of one connection are processed together so its output is locked once per batch
+		stable_sort(batch.begin(), batch.end(), [](const Job &j1, const Job &j2)
+		{
+			return j1.m_Connection.get() < j2.m_Connection.get();
+		});
+
+		vector<shared_ptr<Connection>> ready;
+		for (size_t first = 0; first < batch.size(); )
+		{
+			size_t last = first;
+			output.resize(0);
+			for (; last < batch.size() && batch[last].m_Connection == batch[first].m_Connection; ++last)
+				Process(spa, batch[last].m_Request, output);
+
+			const shared_ptr<Connection> &connection = batch[first].m_Connection;
+			{
+				unique_lock<mutex> lock(connection->m_Mutex);
+				connection->m_InFlight -= last - first;
+				if (connection->m_bClosed)
+				{
+					first = last;
+					continue;
+				}
+				connection->m_Output.insert(connection->m_Output.end(), output.begin(), output.end());
+			}
+			ready.push_back(connection);
+			first = last;
+		}
+
+		if (ready.empty())
+			continue;
+
+		{
+			unique_lock<mutex> lock(m_ReadyMutex);
+			m_Ready.insert(m_Ready.end(), ready.begin(), ready.end());
+		}
+		uint64_t value = 1;
+		if (write(m_WakeUp, &value, sizeof(value)) < 0)
+			continue;
+	}
+}
+
+void GraphServer::Process(ShortestPathAlgorithm &spa, const RequestHeader &request, vector<char> &output) const
+{
+	ResponseHeader response;
+	memset(&response, 0, sizeof(response));
+	response.m_Id = request.m_Id;
+	response.m_Type = request.m_Type;
+	response.m_Status = STATUS_OK;
+
+	unsigned int verticesAmount = m_Graph.GetVerticesAmount();
+	bool bValidU = request.m_U < verticesAmount;
+	bool bValidV = request.m_V < verticesAmount;
+	vector<uint32_t> path;
+	switch (request.m_Type)
+	{
+	case REQUEST_DISTANCE:
+		if (!bValidU || !bValidV)
+			response.m_Status = STATUS_BAD_REQUEST;
+		else
+			response.m_Value = m_pLabels != NULL ? m_pLabels->GetShortestPathLength(request.m_U, request.m_V) :
+				spa.GetShortestPathLength(m_Graph, request.m_U, request.m_V);
+		break;
+	case REQUEST_PATH:
+		if (!bValidU || !bValidV)
+			response.m_Status = STATUS_BAD_REQUEST;
+		else
+		{
+			Path result = spa.GetShortestPath(m_Graph, request.m_U, request.m_V);
+			if (result.GetFinalVertex() != request.m_V)
+				response.m_Value = -1;
+			else
+			{
+				response.m_Value = result.GetWeight();
+				path.assign(result.GetPath().begin(), result.GetPath().end());
+			}
+		}
+		break;
+	case REQUEST_MST:
+		response.m_Value = m_MSTLength == DBL_MAX ? -1 : m_MSTLength;
+		break;
+	case REQUEST_AVERAGE:
+		if (!bValidU)
+			response.m_Status = STATUS_BAD_REQUEST;
+		else
+			response.m_Value = spa.AverageShortestPath(m_Graph, request.m_U);
+		break;
+	default:
+		response.m_Status = STATUS_BAD_REQUEST;
+		break;
+	}
+
+	if (response.m_Status == STATUS_OK && response.m_Value < 0)
+		response.m_Status = STATUS_NO_PATH;
+	response.m_PathLength = path.size();
+
+	const char *header = reinterpret_cast<const char *>(&response);
+	output.insert(output.end(), header, header + sizeof(response));
+	if (!path.empty())
+	{
+		const char *vertices = reinterpret_cast<const char *>(&path[0]);
+		output.insert(output.end(), vertices, vertices + path.size() * sizeof(uint32_t));
+	}
+}
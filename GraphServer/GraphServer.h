@@ -0,0 +1,120 @@
+///  Contains the graph query server declaration
+
+#ifndef GRAPH_SERVER_H__
+#define GRAPH_SERVER_H__
+
+#include "Protocol.h"
+#include "../Graphs/Graph.h"
+#include "../Graphs/HubLabels.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using std::atomic;
+using std::condition_variable;
+using std::deque;
+using std::map;
+using std::mutex;
+using std::shared_ptr;
+using std::thread;
+
+//  This class implements the graph query server on a Unix domain socket (Linux only: it uses epoll and eventfd).
+
+//  The Graph is loaded once and shared by all clients. The event loop thread accepts connections,
+//  reads requests and writes responses with non-blocking I/O. Requests are queued and taken by
+//  workers in batches. Each worker has its own ShortestPathAlgorithm so its buffers are reused
+//  by all requests it processes. Responses of a batch are grouped by connections and appended to
+//  their output buffers, then the event loop is woken up to send them.
+
+//  Flow control: a connection may have a limited amount of queued requests and of unsent output. While it is
+//  at a limit its socket is not read (the client is blocked by the full socket buffer) until workers and
+//  the client catch up, so neither deep pipelining nor a client that doesn't read responses makes the memory grow.
+
+//  The MST length is computed once on start. Distances are answered by the hub labels if they are given
+class GraphServer
+{
+private:
+	//  A client connection. m_Input and m_Events are used only by the event loop, m_Output and m_InFlight are shared with workers
+	struct Connection
+	{
+		int m_Socket;
+		vector<char> m_Input;
+		//  epoll events the socket is registered for
+		unsigned int m_Events;
+		mutex m_Mutex;
+		vector<char> m_Output;
+		size_t m_OutputSent;
+		//  The amount of queued requests whose responses are not in m_Output yet
+		size_t m_InFlight;
+		bool m_bClosed;
+
+		explicit Connection(int socket) : m_Socket(socket), m_Events(0), m_OutputSent(0), m_InFlight(0), m_bClosed(false) { }
+	};
+
+	//  A request waiting for a worker
+	struct Job
+	{
+		shared_ptr<Connection> m_Connection;
+		RequestHeader m_Request;
+	};
+
+	const Graph &m_Graph;
+	const HubLabels *m_pLabels;
+	double m_MSTLength;
+	unsigned int m_ThreadsAmount;
+	unsigned int m_BatchSize;
+	size_t m_CacheBytes;
+
+	int m_ListenSocket;
+	int m_Epoll;
+	//  eventfd to wake the event loop up when there are responses to send or the server stops
+	int m_WakeUp;
+	atomic<bool> m_bStopping;
+	map<int, shared_ptr<Connection>> m_Connections;
+
+	mutex m_JobsMutex;
+	condition_variable m_JobsReady;
+	deque<Job> m_Jobs;
+	bool m_bJobsClosed;
+
+	//  Connections that got new responses
+	mutex m_ReadyMutex;
+	vector<shared_ptr<Connection>> m_Ready;
+
+	//  The server owns sockets so it can't be copied
+	GraphServer(const GraphServer &server);
+	GraphServer &operator=(const GraphServer &server);
+
+	void AcceptConnections();
+	void ReadRequests(const shared_ptr<Connection> &connection);
+	void WriteResponses(const shared_ptr<Connection> &connection);
+	void CloseConnection(const shared_ptr<Connection> &connection);
+	//  Get the amount of requests the connection may queue now (0 if it is at its limits)
+	size_t GetAllowedRequests(const shared_ptr<Connection> &connection) const;
+	//  Register the socket for reading if the connection is under its limits and for writing if it has output to send
+	void UpdateEvents(const shared_ptr<Connection> &connection);
+	//  Send responses of all connections the workers have added responses to
+	void WriteReadyConnections();
+	void WorkerLoop();
+	//  Process the request and append the response to the output
+	void Process(ShortestPathAlgorithm &spa, const RequestHeader &request, vector<char> &output) const;
+public:
+	//  Labels are optional (NULL means distances are found by Dijkstra search).
+	//  batchSize is the maximal amount of requests a worker takes from the queue at once.
+	//  cacheBytes is the search cache limit of each worker (0 means no cache)
+	GraphServer(const Graph &G, const HubLabels *pLabels, unsigned int threadsAmount, unsigned int batchSize = 64, size_t cacheBytes = 0);
+	~GraphServer();
+
+	//  Create the socket at the path (an old file at the path is removed). Returns false on errors
+	bool Listen(const string &socketPath);
+	//  Serve requests until Stop is called
+	void Run();
+	//  Stop the server. It is safe to call from a signal handler
+	void Stop();
+};
+
+#endif
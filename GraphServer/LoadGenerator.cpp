@@ -0,0 +1,240 @@
+//  Load generator for the graph query server: sends random requests over several connections keeping
+//  up to depth requests in flight on each (pipelining) and reports latency percentiles and throughput.
+//  Linux only. Build with: g++ -std=c++11 -O2 -pthread GraphServer/LoadGenerator.cpp
+//  Usage: LoadGenerator <socket> -vertices V [-connections C] [-depth D] [-requests N] [-type distance|path|average|mix]
+#include "Protocol.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using std::mt19937;
+using std::sort;
+using std::string;
+using std::thread;
+using std::vector;
+typedef std::chrono::steady_clock Clock;
+
+//  Settings and results of one connection
+struct ClientState
+{
+	string m_SocketPath;
+	unsigned int m_VerticesAmount;
+	unsigned int m_Depth;
+	unsigned int m_Requests;
+	int m_Type;
+	unsigned int m_Seed;
+
+	vector<double> m_Latencies;
+	unsigned int m_NoPath;
+	unsigned int m_Errors;
+	bool m_bFailed;
+};
+
+static bool SendAll(int socket, const char *data, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t sent = send(socket, data, size, MSG_NOSIGNAL);
+		if (sent <= 0)
+			return false;
+		data += sent;
+		size -= sent;
+	}
+	return true;
+}
+
+static bool ReceiveAll(int socket, char *data, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t received = recv(socket, data, size, 0);
+		if (received <= 0)
+			return false;
+		data += received;
+		size -= received;
+	}
+	return true;
+}
+
+static void RunClient(ClientState *pState)
+{
+	pState->m_bFailed = true;
+	int s = socket(AF_UNIX, SOCK_STREAM, 0);
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, pState->m_SocketPath.c_str(), sizeof(address.sun_path) - 1);
+	if (s < 0 || connect(s, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+	{
+		if (s >= 0)
+			close(s);
+		return;
+	}
+
+	mt19937 random(pState->m_Seed);
+	//  send times of requests by their ids
+	vector<Clock::time_point> sendTimes(pState->m_Requests);
+	vector<uint32_t> path;
+	unsigned int sent = 0;
+	unsigned int received = 0;
+	while (received < pState->m_Requests)
+	{
+		//  Fill the window with requests sent by one write
+		vector<RequestHeader> requests;
+		for (; sent < pState->m_Requests && sent - received < pState->m_Depth; ++sent)
+		{
+			RequestHeader request;
+			memset(&request, 0, sizeof(request));
+			request.m_Id = sent;
+			request.m_Type = static_cast<uint8_t>(pState->m_Type != 0 ? pState->m_Type : REQUEST_DISTANCE + random() % 2);
+			request.m_U = random() % pState->m_VerticesAmount;
+			request.m_V = random() % pState->m_VerticesAmount;
+			sendTimes[sent] = Clock::now();
+			requests.push_back(request);
+		}
+		if (!requests.empty() && !SendAll(s, reinterpret_cast<const char *>(&requests[0]), requests.size() * sizeof(RequestHeader)))
+			break;
+
+		ResponseHeader response;
+		if (!ReceiveAll(s, reinterpret_cast<char *>(&response), sizeof(response)))
+			break;
+		if (response.m_PathLength > 0)
+		{
+			path.resize(response.m_PathLength);
+			if (!ReceiveAll(s, reinterpret_cast<char *>(&path[0]), path.size() * sizeof(uint32_t)))
+				break;
+		}
+		if (response.m_Id >= sent)
+			break;
+
+		std::chrono::duration<double, std::micro> latency = Clock::now() - sendTimes[response.m_Id];
+		pState->m_Latencies.push_back(latency.count());
+		if (response.m_Status == STATUS_NO_PATH)
+			++pState->m_NoPath;
+		else if (response.m_Status != STATUS_OK)
+			++pState->m_Errors;
+		++received;
+	}
+	pState->m_bFailed = received < pState->m_Requests;
+	close(s);
+}
+
+static double Percentile(const vector<double> &sorted, double p)
+{
+	if (sorted.empty())
+		return 0.0;
+	size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+	return sorted[index];
+}
+
+static void PrintUsage()
+{
+	printf("Usage: LoadGenerator <socket> -vertices V [-connections C] [-depth D] [-requests N] [-type distance|path|average|mix]\n");
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	string socketPath = argv[1];
+	unsigned int verticesAmount = 0;
+	unsigned int connections = 4;
+	unsigned int depth = 32;
+	unsigned int requests = 100000;
+	//  0 means mixed distance and path requests
+	int type = REQUEST_DISTANCE;
+	for (int i = 2; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-vertices") == 0 && i + 1 < argc)
+			verticesAmount = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-connections") == 0 && i + 1 < argc)
+			connections = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-depth") == 0 && i + 1 < argc)
+			depth = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-requests") == 0 && i + 1 < argc)
+			requests = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-type") == 0 && i + 1 < argc)
+		{
+			string name = argv[++i];
+			if (name == "distance")
+				type = REQUEST_DISTANCE;
+			else if (name == "path")
+				type = REQUEST_PATH;
+			else if (name == "average")
+				type = REQUEST_AVERAGE;
+			else if (name == "mix")
+				type = 0;
+			else
+			{
+				PrintUsage();
+				return 1;
+			}
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+	if (verticesAmount == 0 || connections == 0 || depth == 0)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	//  Requests are divided between connections
+	vector<ClientState> states(connections);
+	for (unsigned int i = 0; i < connections; ++i)
+	{
+		states[i].m_SocketPath = socketPath;
+		states[i].m_VerticesAmount = verticesAmount;
+		states[i].m_Depth = depth;
+		states[i].m_Requests = requests / connections + (i < requests % connections ? 1 : 0);
+		states[i].m_Type = type;
+		states[i].m_Seed = i + 1;
+		states[i].m_NoPath = 0;
+		states[i].m_Errors = 0;
+		states[i].m_bFailed = false;
+	}
+
+	Clock::time_point start = Clock::now();
+	vector<thread> clients;
+	for (unsigned int i = 0; i < connections; ++i)
+		clients.push_back(thread(RunClient, &states[i]));
+	for (auto it = clients.begin(); it != clients.end(); ++it)
+		it->join();
+	std::chrono::duration<double> elapsed = Clock::now() - start;
+
+	vector<double> latencies;
+	unsigned int noPath = 0;
+	unsigned int errors = 0;
+	unsigned int failed = 0;
+	for (auto it = states.begin(); it != states.end(); ++it)
+	{
+		latencies.insert(latencies.end(), it->m_Latencies.begin(), it->m_Latencies.end());
+		noPath += it->m_NoPath;
+		errors += it->m_Errors;
+		failed += it->m_bFailed ? 1 : 0;
+	}
+	sort(latencies.begin(), latencies.end());
+
+	printf("Requests: %u in %.3f s, %u connections, depth %u\n", static_cast<unsigned int>(latencies.size()), elapsed.count(), connections, depth);
+	printf("QPS: %.0f\n", elapsed.count() > 0 ? latencies.size() / elapsed.count() : 0.0);
+	printf("Latency: p50 %.1f us, p99 %.1f us, max %.1f us\n", Percentile(latencies, 0.5), Percentile(latencies, 0.99),
+		latencies.empty() ? 0.0 : latencies.back());
+	printf("No path: %u, errors: %u, failed connections: %u\n", noPath, errors, failed);
+	return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,57 @@
+///  Contains the binary protocol of the graph query server
+
+#ifndef PROTOCOL_H__
+#define PROTOCOL_H__
+
+#include <cstdint>
+
+//  Requests and responses are fixed size little-endian structures (a path response is followed by
+//  its vertices as 32-bit numbers). A client can send many requests without waiting for responses
+//  (pipelining). Responses may come in any order, they are matched with requests by m_Id
+
+//  Request types
+enum RequestType
+{
+	//  Shortest path length from m_U to m_V
+	REQUEST_DISTANCE = 1,
+	//  Shortest path from m_U to m_V
+	REQUEST_PATH = 2,
+	//  Minimum spanning tree length (m_U and m_V are not used)
+	REQUEST_MST = 3,
+	//  Average shortest path length from m_U
+	REQUEST_AVERAGE = 4
+};
+
+//  Response statuses
+enum ResponseStatus
+{
+	STATUS_OK = 0,
+	//  There is no path (m_Value is -1 like in ShortestPathAlgorithm)
+	STATUS_NO_PATH = 1,
+	STATUS_BAD_REQUEST = 2
+};
+
+#pragma pack(push, 1)
+struct RequestHeader
+{
+	uint32_t m_Id;
+	uint8_t m_Type;
+	uint8_t m_Reserved[3];
+	uint32_t m_U;
+	uint32_t m_V;
+};
+
+struct ResponseHeader
+{
+	uint32_t m_Id;
+	uint8_t m_Type;
+	uint8_t m_Status;
+	uint16_t m_Reserved;
+	//  The amount of path vertices following the header (REQUEST_PATH only)
+	uint32_t m_PathLength;
+	uint32_t m_Reserved2;
+	double m_Value;
+};
+#pragma pack(pop)
+
+#endif
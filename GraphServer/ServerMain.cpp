@@ -0,0 +1,108 @@
+//  Graph query server: loads the Graph once and serves requests of local clients (see Protocol.h).
+//  Linux only. Build with the Graphs library sources except Graphs/main.cpp, for example:
+//  g++ -std=c++11 -O2 -pthread GraphServer/GraphServer.cpp GraphServer/ServerMain.cpp Graphs/{Graph,Components,CompressedAdjacency,HubLabels,KShortestPaths,Relaxation,SearchCache,WorkerPool}.cpp
+//  Usage: GraphServer <socket> (-file <graph> | -random <size> <density>) [-threads N] [-batch N] [-labels <file>] [-cache <MB>]
+//  -labels maps the hub labels file (see HubLabels::Save) and answers distances with it
+//  -cache keeps searches of every worker in the given amount of memory (see SearchCache.h)
+#include "GraphServer.h"
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+
+static GraphServer *g_pServer = NULL;
+
+static void StopServer(int)
+{
+	if (g_pServer != NULL)
+		g_pServer->Stop();
+}
+
+static void PrintUsage()
+{
+	printf("Usage: GraphServer <socket> (-file <graph> | -random <size> <density>) [-threads N] [-batch N] [-labels <file>] [-cache <MB>]\n");
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	string socketPath = argv[1];
+	string graphFile;
+	string labelsFile;
+	unsigned int randomSize = 0;
+	double randomDensity = 0.0;
+	unsigned int threadsAmount = thread::hardware_concurrency();
+	unsigned int batchSize = 64;
+	size_t cacheBytes = 0;
+	for (int i = 2; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-file") == 0 && i + 1 < argc)
+			graphFile = argv[++i];
+		else if (strcmp(argv[i], "-random") == 0 && i + 2 < argc)
+		{
+			randomSize = atoi(argv[++i]);
+			randomDensity = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+			threadsAmount = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-batch") == 0 && i + 1 < argc)
+			batchSize = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-labels") == 0 && i + 1 < argc)
+			labelsFile = argv[++i];
+		else if (strcmp(argv[i], "-cache") == 0 && i + 1 < argc)
+			cacheBytes = static_cast<size_t>(atoi(argv[++i])) << 20;
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+	if (graphFile.empty() == (randomSize == 0))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	srand(static_cast<unsigned int>(time(NULL)));
+	Graph G = graphFile.empty() ? Graph(randomSize, randomDensity, 1.0, 10.0) : Graph(graphFile);
+	if (G.GetVerticesAmount() == 0)
+	{
+		//  a missing file gives an empty graph too
+		printf("The graph has no vertices or can't be loaded\n");
+		return 1;
+	}
+
+	HubLabels labels;
+	if (!labelsFile.empty())
+	{
+		if (!labels.Load(labelsFile) || labels.GetVerticesAmount() != G.GetVerticesAmount())
+		{
+			printf("Can't load labels of the graph from %s\n", labelsFile.c_str());
+			return 1;
+		}
+	}
+
+	GraphServer server(G, labelsFile.empty() ? NULL : &labels, threadsAmount, batchSize, cacheBytes);
+	if (!server.Listen(socketPath))
+	{
+		printf("Can't listen on %s\n", socketPath.c_str());
+		return 1;
+	}
+
+	g_pServer = &server;
+	signal(SIGINT, StopServer);
+	signal(SIGTERM, StopServer);
+	printf("Serving %u vertices, %u edges on %s with %u threads\n", G.GetVerticesAmount(), G.GetEdgesAmount(),
+		socketPath.c_str(), threadsAmount);
+	server.Run();
+	g_pServer = NULL;
+	unlink(socketPath.c_str());
+	return 0;
+}
@@ -0,0 +1,221 @@
+///  Contains the Graph components implementation
+#include "Components.h"
+#include "Graph.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+using std::atomic;
+using std::min;
+using std::swap;
+using std::thread;
+using std::unique_ptr;
+
+//  Find the root of the vertex. Links are shortened on the way (path halving). A failed exchange means only
+//  that another thread has changed the link already, both values point to the same root anyway
+static unsigned int FindRoot(atomic<unsigned int> *parents, unsigned int v)
+{
+	while (true)
+	{
+		unsigned int parent = parents[v].load();
+		if (parent == v)
+			return v;
+
+		unsigned int grandparent = parents[parent].load();
+		if (parent != grandparent)
+			parents[v].compare_exchange_weak(parent, grandparent);
+		v = grandparent;
+	}
+}
+
+//  Link the root with the bigger number to the other one. If the root got a parent
+//  while we were looking for it then try again
+static void Unite(atomic<unsigned int> *parents, unsigned int v1, unsigned int v2)
+{
+	while (true)
+	{
+		v1 = FindRoot(parents, v1);
+		v2 = FindRoot(parents, v2);
+		if (v1 == v2)
+			return;
+
+		if (v1 < v2)
+			swap(v1, v2);
+		unsigned int expected = v1;
+		if (parents[v1].compare_exchange_strong(expected, v2))
+			return;
+	}
+}
+
+GraphComponents::GraphComponents() : m_StrongComponentsAmount(0)
+{
+}
+
+GraphComponents::GraphComponents(const AdjacencyArrays &arrays, unsigned int verticesAmount, bool bDirected, unsigned int threadsAmount) :
+	m_StrongComponentsAmount(0)
+{
+	FindComponents(arrays, verticesAmount, bDirected, threadsAmount);
+	if (bDirected)
+		FindStrongComponents(arrays, verticesAmount);
+	else
+		m_StrongComponentsAmount = GetComponentsAmount();
+}
+
+GraphComponents::~GraphComponents()
+{
+}
+
+void GraphComponents::FindComponents(const AdjacencyArrays &arrays, unsigned int verticesAmount, bool bDirected, unsigned int threadsAmount)
+{
+	unique_ptr<atomic<unsigned int>[]> parents(new atomic<unsigned int>[verticesAmount]);
+	for (unsigned int v = 0; v < verticesAmount; ++v)
+		parents[v].store(v);
+
+	if (threadsAmount == 0)
+		threadsAmount = 1;
+	if (threadsAmount > verticesAmount)
+		threadsAmount = verticesAmount;
+
+	//  Every edge of an undirected graph is stored twice so only one of them is needed
+	auto work = [&](unsigned int first, unsigned int last)
+	{
+		for (unsigned int v = first; v < last; ++v)
+		{
+			const unsigned int *targets = arrays.GetTargets(v);
+			for (unsigned int i = 0; i < arrays.GetDegree(v); ++i)
+				if (bDirected || targets[i] > v)
+					Unite(parents.get(), v, targets[i]);
+		}
+	};
+
+	vector<thread> threads;
+	unsigned int chunk = threadsAmount > 0 ? (verticesAmount + threadsAmount - 1) / threadsAmount : 0;
+	for (unsigned int t = 1; t < threadsAmount; ++t)
+		threads.push_back(thread(work, min(t * chunk, verticesAmount), min((t + 1) * chunk, verticesAmount)));
+	work(0, min(chunk, verticesAmount));
+	for (auto it = threads.begin(); it != threads.end(); ++it)
+		it->join();
+
+	//  The root of a component is its smallest vertex so it is met before other vertices of the component
+	m_Components.resize(verticesAmount);
+	m_Sizes.resize(0);
+	m_Representatives.resize(0);
+	for (unsigned int v = 0; v < verticesAmount; ++v)
+	{
+		unsigned int root = FindRoot(parents.get(), v);
+		if (root == v)
+		{
+			m_Components[v] = m_Representatives.size();
+			m_Representatives.push_back(v);
+			m_Sizes.push_back(0);
+		}
+		else
+			m_Components[v] = m_Components[root];
+		m_Sizes[m_Components[v]]++;
+	}
+}
+
+//  Iterative version of the Tarjan's algorithm so deep graphs don't overflow the stack.
+//  Each frame of the call stack is a vertex and the index of its next edge to visit
+void GraphComponents::FindStrongComponents(const AdjacencyArrays &arrays, unsigned int verticesAmount)
+{
+	vector<unsigned int> index(verticesAmount, UINT_MAX), lowLink(verticesAmount, 0);
+	vector<char> onStack(verticesAmount, 0);
+	vector<unsigned int> stack;
+	vector<pair<unsigned int, unsigned int>> callStack;
+	unsigned int counter = 0;
+
+	m_StrongComponents.assign(verticesAmount, 0);
+	m_StrongComponentsAmount = 0;
+	for (unsigned int s = 0; s < verticesAmount; ++s)
+	{
+		if (index[s] != UINT_MAX)
+			continue;
+
+		index[s] = lowLink[s] = counter++;
+		stack.push_back(s);
+		onStack[s] = 1;
+		callStack.push_back(pair<unsigned int, unsigned int>(s, 0));
+		while (!callStack.empty())
+		{
+			unsigned int v = callStack.back().first;
+			unsigned int edge = callStack.back().second;
+			if (edge < arrays.GetDegree(v))
+			{
+				callStack.back().second++;
+				unsigned int w = arrays.GetTargets(v)[edge];
+				if (index[w] == UINT_MAX)
+				{
+					index[w] = lowLink[w] = counter++;
+					stack.push_back(w);
+					onStack[w] = 1;
+					callStack.push_back(pair<unsigned int, unsigned int>(w, 0));
+				}
+				else if (onStack[w])
+					lowLink[v] = min(lowLink[v], index[w]);
+				continue;
+			}
+
+			callStack.pop_back();
+			if (!callStack.empty())
+				lowLink[callStack.back().first] = min(lowLink[callStack.back().first], lowLink[v]);
+
+			//  v is the root of a strong component. The component is on the top of the stack
+			if (lowLink[v] == index[v])
+			{
+				unsigned int w;
+				do
+				{
+					w = stack.back();
+					stack.pop_back();
+					onStack[w] = 0;
+					m_StrongComponents[w] = m_StrongComponentsAmount;
+				} while (w != v);
+				m_StrongComponentsAmount++;
+			}
+		}
+	}
+}
+
+unsigned int GraphComponents::GetComponentsAmount() const
+{
+	return m_Representatives.size();
+}
+
+unsigned int GraphComponents::GetComponent(unsigned int v) const
+{
+	return m_Components[v];
+}
+
+unsigned int GraphComponents::GetComponentSize(unsigned int component) const
+{
+	return m_Sizes[component];
+}
+
+unsigned int GraphComponents::GetRepresentative(unsigned int component) const
+{
+	return m_Representatives[component];
+}
+
+unsigned int GraphComponents::GetStrongComponentsAmount() const
+{
+	return m_StrongComponentsAmount;
+}
+
+unsigned int GraphComponents::GetStrongComponent(unsigned int v) const
+{
+	return m_StrongComponents.empty() ? m_Components[v] : m_StrongComponents[v];
+}
+
+bool GraphComponents::MayReach(unsigned int u, unsigned int v) const
+{
+	if (u >= m_Components.size() || v >= m_Components.size())
+		return false;
+
+	if (m_Components[u] != m_Components[v])
+		return false;
+
+	//  a path can't lead to a strong component with a bigger number
+	return m_StrongComponents.empty() || m_StrongComponents[v] <= m_StrongComponents[u];
+}
@@ -0,0 +1,60 @@
+///  Contains the Graph components declaration
+
+#ifndef COMPONENTS_H__
+#define COMPONENTS_H__
+
+#include <vector>
+
+using std::vector;
+
+class AdjacencyArrays;
+
+//  This class stores connected components of the Graph.
+
+//  Components are found by the lock-free union-find. Vertices are split between threads and every
+//  thread unites the ends of the edges of its vertices. A root is always linked to a root with a smaller number
+//  so the root of a component is its smallest vertex and the result doesn't depend on the threads.
+//  Components are numbered in the order of their smallest vertices.
+
+//  For directed graphs these are weakly connected components (edge directions are ignored) and
+//  strongly connected components are found additionally by Tarjan's algorithm. Tarjan's algorithm
+//  numbers strong components in the reverse topological order: if there is a path from the component A
+//  to the component B then B < A. It lets some unreachable vertices be rejected without a search
+class GraphComponents
+{
+private:
+	vector<unsigned int> m_Components;
+	vector<unsigned int> m_Sizes;
+	vector<unsigned int> m_Representatives;
+	//  Empty for undirected graphs (strong components are the same as connected ones)
+	vector<unsigned int> m_StrongComponents;
+	unsigned int m_StrongComponentsAmount;
+
+	//  Find weakly connected components by the parallel union-find
+	void FindComponents(const AdjacencyArrays &arrays, unsigned int verticesAmount, bool bDirected, unsigned int threadsAmount);
+	//  Find strongly connected components by the Tarjan's algorithm
+	void FindStrongComponents(const AdjacencyArrays &arrays, unsigned int verticesAmount);
+public:
+	GraphComponents();
+	//  Find components of the Graph with the given adjacency using threadsAmount threads
+	GraphComponents(const AdjacencyArrays &arrays, unsigned int verticesAmount, bool bDirected, unsigned int threadsAmount);
+	~GraphComponents();
+
+	//  Get the amount of (weakly) connected components
+	unsigned int GetComponentsAmount() const;
+	//  Get the component of the vertex
+	unsigned int GetComponent(unsigned int v) const;
+	//  Get the amount of vertices in the component
+	unsigned int GetComponentSize(unsigned int component) const;
+	//  Get the smallest vertex of the component
+	unsigned int GetRepresentative(unsigned int component) const;
+	//  Get the amount of strongly connected components
+	unsigned int GetStrongComponentsAmount() const;
+	//  Get the strong component of the vertex
+	unsigned int GetStrongComponent(unsigned int v) const;
+
+	//  Returns false if there is definitely no path from u to v. O(1)
+	bool MayReach(unsigned int u, unsigned int v) const;
+};
+
+#endif
@@ -0,0 +1,278 @@
+///  Contains the compressed adjacency implementation
+#include "CompressedAdjacency.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using std::max;
+using std::min;
+using std::sort;
+
+CompressedEdgeIterator::CompressedEdgeIterator(const CompressedAdjacency *adjacency, unsigned int v, const unsigned char *position, unsigned int remaining) :
+	m_Adjacency(adjacency), m_Position(position), m_Remaining(remaining), m_Edge(v, 0, 0.0)
+{
+	if (m_Remaining > 0)
+		Decode();
+}
+
+void CompressedEdgeIterator::Decode()
+{
+	unsigned int target = m_Edge.GetEndVertexNumber() + CompressedAdjacency::ReadVarint(m_Position);
+	double weight = m_Adjacency->ReadWeight(m_Position);
+	m_Edge = Edge(m_Edge.GetStartVertexNumber(), target, weight);
+}
+
+CompressedEdgeIterator &CompressedEdgeIterator::operator++()
+{
+	if (--m_Remaining > 0)
+		Decode();
+	return *this;
+}
+
+CompressedAdjacency::CompressedAdjacency() : m_Offsets(1, 0), m_EdgesAmount(0), m_WeightsType(COMPRESSED_WEIGHTS_DOUBLE),
+	m_WeightMin(0.0), m_WeightStep(0.0)
+{
+}
+
+//  Edges are taken from the lists of the Graph so its arrays are not built only to be compressed
+CompressedAdjacency::CompressedAdjacency(const Graph &G, CompressedWeights weights) : m_EdgesAmount(0), m_WeightsType(weights),
+	m_WeightMin(0.0), m_WeightStep(0.0)
+{
+	unsigned int verticesAmount = G.GetVerticesAmount();
+
+	//  the range of weights for quantization
+	double weightMin = DBL_MAX, weightMax = -DBL_MAX;
+	for (unsigned int v = 0; v < verticesAmount; ++v)
+	{
+		const list<Edge> &edges = G.GetNodeEdges(v);
+		for (auto it = edges.begin(); it != edges.end(); ++it)
+		{
+			weightMin = min(weightMin, it->GetEdgeWeight());
+			weightMax = max(weightMax, it->GetEdgeWeight());
+		}
+	}
+	SetWeightsRange(weightMin, weightMax);
+
+	vector<pair<unsigned int, double>> edges;
+	m_Offsets.reserve(verticesAmount + 1);
+	for (unsigned int v = 0; v < verticesAmount; ++v)
+	{
+		const list<Edge> &vertexEdges = G.GetNodeEdges(v);
+		edges.resize(0);
+		for (auto it = vertexEdges.begin(); it != vertexEdges.end(); ++it)
+			edges.push_back(pair<unsigned int, double>(it->GetEndVertexNumber(), it->GetEdgeWeight()));
+		AddVertex(edges);
+	}
+	FinishBytes();
+}
+
+//  The first pass counts edges of every vertex and finds the range of weights, the second one puts edges
+//  to their places in the arrays of all edges. So the edges are kept once in the arrays before they are compressed
+CompressedAdjacency::CompressedAdjacency(const string &filename, CompressedWeights weights) : m_EdgesAmount(0), m_WeightsType(weights),
+	m_WeightMin(0.0), m_WeightStep(0.0)
+{
+	ifstream fin(filename, ios_base::in);
+	int size = 0;
+	if (!(fin >> size) || size < 0)
+		size = 0;
+	unsigned int verticesAmount = static_cast<unsigned int>(size);
+
+	vector<size_t> positions(verticesAmount + 1, 0);
+	double weightMin = DBL_MAX, weightMax = -DBL_MAX;
+	int v1, v2, len;
+	while (fin >> v1 >> v2 >> len)
+		if (v1 >= 0 && v2 >= 0 && v1 < size && v2 < size)
+		{
+			positions[v1 + 1]++;
+			weightMin = min(weightMin, static_cast<double>(len));
+			weightMax = max(weightMax, static_cast<double>(len));
+		}
+	SetWeightsRange(weightMin, weightMax);
+	for (unsigned int v = 0; v < verticesAmount; ++v)
+		positions[v + 1] += positions[v];
+
+	//  weights are integers in the file
+	vector<unsigned int> targets(positions[verticesAmount]);
+	vector<int> fileWeights(positions[verticesAmount]);
+	fin.clear();
+	fin.seekg(0);
+	fin >> size;
+	while (fin >> v1 >> v2 >> len)
+		if (v1 >= 0 && v2 >= 0 && v1 < size && v2 < size)
+		{
+			size_t position = positions[v1]++;
+			targets[position] = v2;
+			fileWeights[position] = len;
+		}
+
+	//  positions[v] is the end of the edges of v now
+	vector<pair<unsigned int, double>> edges;
+	m_Offsets.reserve(verticesAmount + 1);
+	for (unsigned int v = 0; v < verticesAmount; ++v)
+	{
+		edges.resize(0);
+		for (size_t i = v > 0 ? positions[v - 1] : 0; i < positions[v]; ++i)
+			edges.push_back(pair<unsigned int, double>(targets[i], fileWeights[i]));
+		AddVertex(edges);
+	}
+	FinishBytes();
+}
+
+CompressedAdjacency::~CompressedAdjacency()
+{
+}
+
+//  Without edges the range is empty and all the quantized weights are 0
+void CompressedAdjacency::SetWeightsRange(double weightMin, double weightMax)
+{
+	if (weightMin > weightMax)
+		weightMin = weightMax = 0.0;
+	m_WeightMin = weightMin;
+	m_WeightStep = (weightMax - weightMin) / 65535.0;
+}
+
+void CompressedAdjacency::AddVertex(vector<pair<unsigned int, double>> &edges)
+{
+	m_Offsets.push_back(m_Bytes.size());
+
+	//  Sorted end vertices give small differences
+	sort(edges.begin(), edges.end());
+	WriteVarint(edges.size());
+	unsigned int previous = 0;
+	for (auto it = edges.begin(); it != edges.end(); ++it)
+	{
+		WriteVarint(it->first - previous);
+		WriteWeight(it->second);
+		previous = it->first;
+	}
+	m_EdgesAmount += edges.size();
+}
+
+void CompressedAdjacency::FinishBytes()
+{
+	m_Offsets.push_back(m_Bytes.size());
+	//  the source may be much bigger than the compressed adjacency so the reserve is given back
+	vector<unsigned char>(m_Bytes).swap(m_Bytes);
+}
+
+void CompressedAdjacency::WriteVarint(unsigned int value)
+{
+	while (value >= 0x80)
+	{
+		m_Bytes.push_back(static_cast<unsigned char>(value | 0x80));
+		value >>= 7;
+	}
+	m_Bytes.push_back(static_cast<unsigned char>(value));
+}
+
+//  Weights are copied byte by byte because they are not aligned in the stream
+void CompressedAdjacency::WriteWeight(double weight)
+{
+	unsigned char bytes[sizeof(double)];
+	size_t size = 0;
+	switch (m_WeightsType)
+	{
+	case COMPRESSED_WEIGHTS_FLOAT:
+		{
+			float value = static_cast<float>(weight);
+			memcpy(bytes, &value, sizeof(value));
+			size = sizeof(value);
+		}
+		break;
+	case COMPRESSED_WEIGHTS_QUANTIZED:
+		{
+			unsigned short value = m_WeightStep > 0.0 ? static_cast<unsigned short>(floor((weight - m_WeightMin) / m_WeightStep + 0.5)) : 0;
+			memcpy(bytes, &value, sizeof(value));
+			size = sizeof(value);
+		}
+		break;
+	default:
+		memcpy(bytes, &weight, sizeof(weight));
+		size = sizeof(weight);
+		break;
+	}
+	m_Bytes.insert(m_Bytes.end(), bytes, bytes + size);
+}
+
+unsigned int CompressedAdjacency::ReadVarint(const unsigned char *&position)
+{
+	unsigned int value = 0;
+	unsigned int shift = 0;
+	while (*position & 0x80)
+	{
+		value |= static_cast<unsigned int>(*position++ & 0x7F) << shift;
+		shift += 7;
+	}
+	value |= static_cast<unsigned int>(*position++) << shift;
+	return value;
+}
+
+double CompressedAdjacency::ReadWeight(const unsigned char *&position) const
+{
+	switch (m_WeightsType)
+	{
+	case COMPRESSED_WEIGHTS_FLOAT:
+		{
+			float value;
+			memcpy(&value, position, sizeof(value));
+			position += sizeof(value);
+			return value;
+		}
+	case COMPRESSED_WEIGHTS_QUANTIZED:
+		{
+			unsigned short value;
+			memcpy(&value, position, sizeof(value));
+			position += sizeof(value);
+			return m_WeightMin + value * m_WeightStep;
+		}
+	default:
+		{
+			double value;
+			memcpy(&value, position, sizeof(value));
+			position += sizeof(value);
+			return value;
+		}
+	}
+}
+
+unsigned int CompressedAdjacency::GetVerticesAmount() const
+{
+	return m_Offsets.size() - 1;
+}
+
+unsigned int CompressedAdjacency::GetEdgesAmount() const
+{
+	return m_EdgesAmount;
+}
+
+unsigned int CompressedAdjacency::GetDegree(unsigned int v) const
+{
+	const unsigned char *position = m_Bytes.data() + m_Offsets[v];
+	return ReadVarint(position);
+}
+
+CompressedEdgeRange CompressedAdjacency::operator[](unsigned int v) const
+{
+	const unsigned char *position = m_Bytes.data() + m_Offsets[v];
+	unsigned int degree = ReadVarint(position);
+	return CompressedEdgeRange(this, v, position, degree);
+}
+
+unsigned int CompressedAdjacency::DecodeEdges(unsigned int v, unsigned int *targets, double *weights) const
+{
+	const unsigned char *position = m_Bytes.data() + m_Offsets[v];
+	unsigned int degree = ReadVarint(position);
+	unsigned int target = 0;
+	for (unsigned int i = 0; i < degree; ++i)
+	{
+		target += ReadVarint(position);
+		targets[i] = target;
+		weights[i] = ReadWeight(position);
+	}
+	return degree;
+}
+
+size_t CompressedAdjacency::GetMemoryUsage() const
+{
+	return m_Bytes.capacity() * sizeof(unsigned char) + m_Offsets.capacity() * sizeof(size_t) + sizeof(*this);
+}
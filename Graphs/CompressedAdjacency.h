@@ -0,0 +1,127 @@
+///  Contains the compressed adjacency declaration
+
+#ifndef COMPRESSED_ADJACENCY_H__
+#define COMPRESSED_ADJACENCY_H__
+
+#include "Graph.h"
+
+//  How edge weights are stored in the compressed adjacency
+enum CompressedWeights
+{
+	//  exact weights, 8 bytes per edge
+	COMPRESSED_WEIGHTS_DOUBLE,
+	//  4 bytes per edge, weights are rounded to float
+	COMPRESSED_WEIGHTS_FLOAT,
+	//  2 bytes per edge, weights are rounded to one of 65536 values evenly spread between the minimal and maximal weight
+	COMPRESSED_WEIGHTS_QUANTIZED
+};
+
+class CompressedAdjacency;
+
+//  This class implements an iterator over the edges of a vertex in the compressed adjacency.
+//  It decodes edges one by one while it moves so it behaves like an iterator of list<Edge>
+class CompressedEdgeIterator
+{
+private:
+	const CompressedAdjacency *m_Adjacency;
+	const unsigned char *m_Position;
+	unsigned int m_Remaining;
+	//  The current edge. Its end vertex is the base for the next difference
+	Edge m_Edge;
+
+	//  Decode the edge at m_Position to m_Edge and move m_Position to the next edge
+	void Decode();
+public:
+	CompressedEdgeIterator(const CompressedAdjacency *adjacency, unsigned int v, const unsigned char *position, unsigned int remaining);
+	~CompressedEdgeIterator() { }
+
+	const Edge &operator*() const { return m_Edge; }
+	const Edge *operator->() const { return &m_Edge; }
+	CompressedEdgeIterator &operator++();
+	//  Iterators of the same vertex are compared by the amount of remaining edges
+	bool operator==(const CompressedEdgeIterator &it) const { return m_Remaining == it.m_Remaining; }
+	bool operator!=(const CompressedEdgeIterator &it) const { return m_Remaining != it.m_Remaining; }
+};
+
+//  Edges of a vertex in the compressed adjacency. It can be used in the same way as list<Edge>
+class CompressedEdgeRange
+{
+private:
+	const CompressedAdjacency *m_Adjacency;
+	unsigned int m_Vertex;
+	const unsigned char *m_Position;
+	unsigned int m_Degree;
+public:
+	CompressedEdgeRange(const CompressedAdjacency *adjacency, unsigned int v, const unsigned char *position, unsigned int degree) :
+		m_Adjacency(adjacency), m_Vertex(v), m_Position(position), m_Degree(degree) { }
+	~CompressedEdgeRange() { }
+
+	CompressedEdgeIterator begin() const { return CompressedEdgeIterator(m_Adjacency, m_Vertex, m_Position, m_Degree); }
+	CompressedEdgeIterator end() const { return CompressedEdgeIterator(m_Adjacency, m_Vertex, m_Position, 0); }
+	size_t size() const { return m_Degree; }
+};
+
+//  This class implements the read-only compressed adjacency of the Graph.
+
+//  Edges of each vertex are sorted by their end vertices and stored in a byte stream:
+//  the amount of edges, then for each edge the difference between its end vertex and the end vertex of
+//  the previous edge (the first one is stored as is) and the edge weight. Numbers are stored as varints:
+//  7 bits per byte, the high bit is set if more bytes follow. Close neighbours take 1 byte instead of 4.
+//  With quantized weights an edge takes about 3 bytes instead of 40+ bytes of a list<Edge> node.
+
+//  Edges are decoded on the fly by CompressedEdgeIterator (adjacency[v] has begin() and end() like list<Edge>)
+//  or by DecodeEdges which fills arrays for relaxation kernels. ShortestPathAlgorithm and Graph::PrimMST
+//  can work on it directly.
+
+//  It is built from a Graph or straight from a graph file. A graph too big for list<Edge> can be read from
+//  the file: only plain arrays of its edges are kept while it is compressed
+class CompressedAdjacency
+{
+private:
+	vector<unsigned char> m_Bytes;
+	//  Offset of the edges of each vertex in m_Bytes. The stream of a big graph can be longer than 4 GiB
+	vector<size_t> m_Offsets;
+	unsigned int m_EdgesAmount;
+	CompressedWeights m_WeightsType;
+	//  Quantized weight q means m_WeightMin + q * m_WeightStep
+	double m_WeightMin;
+	double m_WeightStep;
+
+	//  Set the range of weights for the quantization
+	void SetWeightsRange(double weightMin, double weightMax);
+	//  Append the edges of the next vertex (they are sorted here)
+	void AddVertex(vector<pair<unsigned int, double>> &edges);
+	//  Close the stream after the last vertex
+	void FinishBytes();
+	void WriteVarint(unsigned int value);
+	void WriteWeight(double weight);
+public:
+	CompressedAdjacency();
+	//  Compress the adjacency of the Graph
+	CompressedAdjacency(const Graph &G, CompressedWeights weights);
+	//  Compress the graph from a file of the Graph(filename) format without building the Graph.
+	//  The graph is directed like the one read by Graph
+	CompressedAdjacency(const string &filename, CompressedWeights weights);
+	~CompressedAdjacency();
+
+	//  Get number of vertices
+	unsigned int GetVerticesAmount() const;
+	//  Get number of edges
+	unsigned int GetEdgesAmount() const;
+	//  Get the amount of edges of the vertex
+	unsigned int GetDegree(unsigned int v) const;
+	//  Get the edges of the vertex. Use begin() and end() of the result to iterate over them
+	CompressedEdgeRange operator[](unsigned int v) const;
+	//  Decode all edges of the vertex to the arrays (they must have room for GetDegree(v) elements).
+	//  Returns the amount of edges
+	unsigned int DecodeEdges(unsigned int v, unsigned int *targets, double *weights) const;
+	//  Get the amount of memory used by the adjacency in bytes
+	size_t GetMemoryUsage() const;
+
+	//  Read a varint at the position and move the position to the next byte after it
+	static unsigned int ReadVarint(const unsigned char *&position);
+	//  Read a weight at the position and move the position to the next byte after it
+	double ReadWeight(const unsigned char *&position) const;
+};
+
+#endif
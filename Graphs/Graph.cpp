@@ -1,5 +1,10 @@
 ///  Contains Graph related classes implementation
 #include "Graph.h"
+#include "CompressedAdjacency.h"
+#include <thread>
+
+using std::lock_guard;
+using std::thread;
 
 //  This function generates a random double between dMin and dMax
 double GenerateRandomDouble(double dMin, double dMax)
@@ -40,7 +45,81 @@ void Edge::SetEdgeWeight(double weight)
 	m_Weight = weight;
 }
 
-Graph::Graph(unsigned int size) : m_EdgeList(size), m_EdgesAmount(0)
+AdjacencyArrays::AdjacencyArrays() : m_Offsets(1, 0)
+{
+}
+
+AdjacencyArrays::AdjacencyArrays(const vector<list<Edge>> &edgeList) : m_Offsets(edgeList.size() + 1, 0)
+{
+	for (size_t i = 0; i < edgeList.size(); ++i)
+		m_Offsets[i + 1] = m_Offsets[i] + edgeList[i].size();
+
+	m_Targets.reserve(m_Offsets.back());
+	m_Weights.reserve(m_Offsets.back());
+	for (size_t i = 0; i < edgeList.size(); ++i)
+		for (auto it = edgeList[i].begin(); it != edgeList[i].end(); ++it)
+		{
+			m_Targets.push_back(it->GetEndVertexNumber());
+			m_Weights.push_back(it->GetEdgeWeight());
+		}
+}
+
+AdjacencyArrays::~AdjacencyArrays()
+{
+}
+
+//  Counting sort of the edges by their end vertices
+AdjacencyArrays AdjacencyArrays::Reverse() const
+{
+	AdjacencyArrays reversed;
+	unsigned int verticesAmount = m_Offsets.size() - 1;
+	reversed.m_Offsets.assign(verticesAmount + 1, 0);
+	for (auto it = m_Targets.begin(); it != m_Targets.end(); ++it)
+		reversed.m_Offsets[*it + 1]++;
+	for (unsigned int v = 0; v < verticesAmount; ++v)
+		reversed.m_Offsets[v + 1] += reversed.m_Offsets[v];
+
+	vector<unsigned int> positions(reversed.m_Offsets.begin(), reversed.m_Offsets.end() - 1);
+	reversed.m_Targets.resize(m_Targets.size());
+	reversed.m_Weights.resize(m_Weights.size());
+	for (unsigned int v = 0; v < verticesAmount; ++v)
+		for (unsigned int i = m_Offsets[v]; i < m_Offsets[v + 1]; ++i)
+		{
+			unsigned int position = positions[m_Targets[i]]++;
+			reversed.m_Targets[position] = v;
+			reversed.m_Weights[position] = m_Weights[i];
+		}
+	return reversed;
+}
+
+//  Edges of v1 are in the order of its list so the first edge to v2 is the same one
+bool AdjacencyArrays::SetWeight(unsigned int v1, unsigned int v2, double weight)
+{
+	for (unsigned int i = m_Offsets[v1]; i < m_Offsets[v1 + 1]; ++i)
+		if (m_Targets[i] == v2)
+		{
+			m_Weights[i] = weight;
+			return true;
+		}
+	return false;
+}
+
+size_t AdjacencyArrays::GetMemoryUsage() const
+{
+	return m_Offsets.capacity() * sizeof(unsigned int) + m_Targets.capacity() * sizeof(unsigned int) +
+		m_Weights.capacity() * sizeof(double) + sizeof(*this);
+}
+
+//  Versions are taken from one counter so two different Graphs never have the same version
+static atomic<unsigned long long> g_LastGraphVersion(0);
+
+static unsigned long long NewGraphVersion()
+{
+	return ++g_LastGraphVersion;
+}
+
+Graph::Graph(unsigned int size) : m_EdgeList(size), m_EdgesAmount(0), m_bDirected(false), m_bArraysValid(false), m_bReverseArraysValid(false),
+	m_bComponentsValid(false), m_Version(NewGraphVersion())
 {
 }
 
@@ -48,7 +127,8 @@ Graph::Graph(unsigned int size) : m_EdgeList(size), m_EdgesAmount(0)
 //  a random double between 0 and 1. If it is less than the density then create an edge.
 //  It means the edge in generated in density cases of 1 (or in density % cases).
 //  It equals that graph has the given density
-Graph::Graph(unsigned int size, double density, double distance_min, double distance_max) : m_EdgeList(size), m_EdgesAmount(0)
+Graph::Graph(unsigned int size, double density, double distance_min, double distance_max) : m_EdgeList(size), m_EdgesAmount(0), m_bDirected(false),
+	m_bArraysValid(false), m_bReverseArraysValid(false), m_bComponentsValid(false), m_Version(NewGraphVersion())
 {
 	double random_propability, random_distance;
 	random_propability = random_distance = 0.0;
@@ -73,7 +153,8 @@ Graph::Graph(unsigned int size, double density, double distance_min, double dist
 }
 
 
-Graph::Graph(const string &filename) : m_EdgesAmount(0)
+Graph::Graph(const string &filename) : m_EdgesAmount(0), m_bDirected(true), m_bArraysValid(false), m_bReverseArraysValid(false),
+	m_bComponentsValid(false), m_Version(NewGraphVersion())
 {
 	ifstream fin(filename, ios_base::in);
 
@@ -97,6 +178,51 @@ Graph::Graph(const string &filename) : m_EdgesAmount(0)
 	fin.close();
 }
 
+//  The source is locked so its lazy parts are not copied while another thread builds them
+Graph::Graph(const Graph &G) : m_EdgeList(G.m_EdgeList), m_EdgesAmount(G.m_EdgesAmount), m_bDirected(G.m_bDirected),
+	m_bArraysValid(false), m_bReverseArraysValid(false), m_bComponentsValid(false), m_Version(G.m_Version)
+{
+	lock_guard<mutex> lock(G.m_CacheMutex);
+	if (G.m_bArraysValid)
+	{
+		m_Arrays = G.m_Arrays;
+		m_bArraysValid = true;
+	}
+	if (G.m_bReverseArraysValid)
+	{
+		m_ReverseArrays = G.m_ReverseArrays;
+		m_bReverseArraysValid = true;
+	}
+	if (G.m_bComponentsValid)
+	{
+		m_Components = G.m_Components;
+		m_bComponentsValid = true;
+	}
+}
+
+Graph &Graph::operator=(const Graph &G)
+{
+	if (this == &G)
+		return *this;
+
+	m_EdgeList = G.m_EdgeList;
+	m_EdgesAmount = G.m_EdgesAmount;
+	m_bDirected = G.m_bDirected;
+	m_Version = G.m_Version;
+
+	lock_guard<mutex> lock(G.m_CacheMutex);
+	m_bArraysValid = G.m_bArraysValid.load();
+	if (m_bArraysValid)
+		m_Arrays = G.m_Arrays;
+	m_bReverseArraysValid = G.m_bReverseArraysValid.load();
+	if (m_bReverseArraysValid)
+		m_ReverseArrays = G.m_ReverseArrays;
+	m_bComponentsValid = G.m_bComponentsValid.load();
+	if (m_bComponentsValid)
+		m_Components = G.m_Components;
+	return *this;
+}
+
 Graph::~Graph()
 {
 }
@@ -111,6 +237,16 @@ unsigned int Graph::GetEdgesAmount() const
 	return m_EdgesAmount;
 }
 
+bool Graph::IsDirected() const
+{
+	return m_bDirected;
+}
+
+unsigned long long Graph::GetVersion() const
+{
+	return m_Version;
+}
+
 unsigned int Graph::GetNodeValue(unsigned int v1) const
 {
 	return v1;
@@ -153,6 +289,63 @@ const list<Edge> &Graph::GetNodeEdges(unsigned int v) const
 	return m_EdgeList[v];
 }
 
+//  The flag is checked again under the lock so the arrays are built once when several threads need them
+const AdjacencyArrays &Graph::GetAdjacencyArrays() const
+{
+	if (!m_bArraysValid)
+	{
+		lock_guard<mutex> lock(m_CacheMutex);
+		if (!m_bArraysValid)
+		{
+			m_Arrays = AdjacencyArrays(m_EdgeList);
+			m_bArraysValid = true;
+		}
+	}
+
+	return m_Arrays;
+}
+
+const AdjacencyArrays &Graph::GetReverseAdjacencyArrays() const
+{
+	if (!m_bDirected)
+		return GetAdjacencyArrays();
+
+	const AdjacencyArrays &arrays = GetAdjacencyArrays();
+	if (!m_bReverseArraysValid)
+	{
+		lock_guard<mutex> lock(m_CacheMutex);
+		if (!m_bReverseArraysValid)
+		{
+			m_ReverseArrays = arrays.Reverse();
+			m_bReverseArraysValid = true;
+		}
+	}
+
+	return m_ReverseArrays;
+}
+
+//  A query doesn't start threads, only BuildCaches finds components in parallel
+const GraphComponents &Graph::GetComponents() const
+{
+	if (!m_bComponentsValid)
+		BuildCaches(1);
+
+	return m_Components;
+}
+
+void Graph::BuildCaches(unsigned int threadsAmount) const
+{
+	//  the arrays are taken before the lock, their getters lock it themselves
+	const AdjacencyArrays &arrays = GetAdjacencyArrays();
+	GetReverseAdjacencyArrays();
+	lock_guard<mutex> lock(m_CacheMutex);
+	if (!m_bComponentsValid)
+	{
+		m_Components = GraphComponents(arrays, GetVerticesAmount(), m_bDirected, threadsAmount);
+		m_bComponentsValid = true;
+	}
+}
+
 void Graph::AddEdge(unsigned int v1, unsigned int v2, double distance)
 {
 	//  don't need to check whether v1 or v2 are more of the edges amount or not because it's done in the beginning of the Adjacent method
@@ -161,6 +354,10 @@ void Graph::AddEdge(unsigned int v1, unsigned int v2, double distance)
 		m_EdgeList[v1].push_back(Edge(v1, v2, distance));
 		m_EdgeList[v2].push_back(Edge(v2, v1, distance));
 		m_EdgesAmount++;
+		m_bArraysValid = false;
+		m_bReverseArraysValid = false;
+		m_bComponentsValid = false;
+		m_Version = NewGraphVersion();
 	}
 }
 
@@ -193,6 +390,10 @@ void Graph::DeleteEdge(unsigned int v1, unsigned int v2)
 			}
 
 		m_EdgesAmount--;
+		m_bArraysValid = false;
+		m_bReverseArraysValid = false;
+		m_bComponentsValid = false;
+		m_Version = NewGraphVersion();
 	}
 }
 
@@ -203,71 +404,158 @@ void Graph::SetNodeValue(unsigned int v1, double value)
 
 void Graph::SetEdgeValue(unsigned int v1, unsigned int v2, double value)
 {
-	if (Adjacent(v1, v2))
-	{
-		for (auto it = m_EdgeList[v1].begin(); it != m_EdgeList[v1].end(); ++it)
-			if (it->GetEndVertexNumber() == v2)
-			{
-				it->SetEdgeWeight(value);
-				return;
-			}
-	}
+	if (!SetListWeight(v1, v2, value))
+		return;
+	if (!m_bDirected)
+		SetListWeight(v2, v1, value);
+	m_Version = NewGraphVersion();
 }
 
-Graph Graph::PrimMST(double &length)
+//  The arrays are patched instead of being rebuilt by the next query
+bool Graph::SetListWeight(unsigned int v1, unsigned int v2, double value)
+{
+	if (v1 >= GetVerticesAmount())
+		return false;
+
+	for (auto it = m_EdgeList[v1].begin(); it != m_EdgeList[v1].end(); ++it)
+		if (it->GetEndVertexNumber() == v2)
+		{
+			it->SetEdgeWeight(value);
+			if (m_bArraysValid && !m_Arrays.SetWeight(v1, v2, value))
+				m_bArraysValid = false;
+			//  the reversed edges of v2 keep the order of the lists of their sources so it is the same edge too
+			if (m_bReverseArraysValid && !m_ReverseArrays.SetWeight(v2, v1, value))
+				m_bReverseArraysValid = false;
+			return true;
+		}
+	return false;
+}
+
+//  Start with a single vertex and add the best edge to an unvisited vertex while there is one.
+//  adjacency[v] is list<Edge> for the Graph itself and the range of decoded edges for the compressed adjacency
+template<typename TAdjacency>
+bool Graph::PrimComponent(const TAdjacency &adjacency, unsigned int start, unsigned int componentSize, vector<char> &visited, vector<Edge> &edges, double &length)
 {
-	Graph G(GetVerticesAmount());
-	list<unsigned int> closeSet;
 	PriorityQueue<Edge, double> PQ;
-	//  we should check if the Graph is disconnected and return the tree of 0 size in that case
-	bool bDisconnected = true;
+	unsigned int reached = 1;
 
-	length = 0;
-	if (GetVerticesAmount() == 0)
-		return G;
-	
-	//  Start with a single vertex
-	closeSet.push_back(0);
-	for (auto it = m_EdgeList[0].begin(); it != m_EdgeList[0].end(); ++it)
+	visited[start] = 1;
+	const auto &startEdges = adjacency[start];
+	for (auto it = startEdges.begin(); it != startEdges.end(); ++it)
 		PQ.Insert(*it, it->GetEdgeWeight());
 
-	//  Algorithm should work while the resulting tree doesn't contain all nodes 
-	//  and Graph is not disconnected (second condition)
-	while (closeSet.size() != G.GetVerticesAmount() && PQ.Size() > 0)
+	while (reached < componentSize && !PQ.Empty())
 	{
-		bDisconnected = true;
-		Edge e;
 		//  Get an unvisited vertex with the highest priority
-		while (PQ.Size() > 0)
-		{
-			e =  PQ.Top();
-			PQ.Pop();
-
-			if (find(closeSet.begin(), closeSet.end(), e.GetEndVertexNumber()) == closeSet.end())
-			{
-				bDisconnected = false;
-				break;
-			}
-		}
-
-		if (bDisconnected)
-			break;
+		Edge e = PQ.Top();
+		PQ.Pop();
+		if (visited[e.GetEndVertexNumber()])
+			continue;
 
 		//  Add the vertex to the tree and its edges to the queue
-		G.AddEdge(e);
+		visited[e.GetEndVertexNumber()] = 1;
+		reached++;
+		edges.push_back(e);
 		length += e.GetEdgeWeight();
-		closeSet.push_back(e.GetEndVertexNumber());
-		for (auto it = m_EdgeList[e.GetEndVertexNumber()].begin(); it != m_EdgeList[e.GetEndVertexNumber()].end(); ++it)
+		const auto &nextEdges = adjacency[e.GetEndVertexNumber()];
+		for (auto it = nextEdges.begin(); it != nextEdges.end(); ++it)
 			PQ.Insert(*it, it->GetEdgeWeight());
 	}
 
-	if (!bDisconnected)
-		return G;
-	else
+	return reached == componentSize;
+}
+
+Graph Graph::PrimMST(double &length) const
+{
+	length = 0;
+	if (GetVerticesAmount() == 0)
+		return Graph(0);
+
+	//  A disconnected Graph has no spanning tree. Components tell it before building the tree
+	if (GetComponents().GetComponentsAmount() > 1)
+	{
+		length = DBL_MAX;
+		return Graph(0);
+	}
+
+	vector<char> visited(GetVerticesAmount(), 0);
+	vector<Edge> edges;
+	if (!PrimComponent(m_EdgeList, 0, GetVerticesAmount(), visited, edges, length))
+	{
+		length = DBL_MAX;
+		return Graph(0);
+	}
+
+	Graph G(GetVerticesAmount());
+	for (auto it = edges.begin(); it != edges.end(); ++it)
+		G.AddEdge(*it);
+	return G;
+}
+
+//  There are no components for the compressed adjacency so disconnection is found when Prim's algorithm gets stuck
+Graph Graph::PrimMST(const CompressedAdjacency &adjacency, double &length)
+{
+	length = 0;
+	if (adjacency.GetVerticesAmount() == 0)
+		return Graph(0);
+
+	vector<char> visited(adjacency.GetVerticesAmount(), 0);
+	vector<Edge> edges;
+	if (!PrimComponent(adjacency, 0, adjacency.GetVerticesAmount(), visited, edges, length))
 	{
 		length = DBL_MAX;
 		return Graph(0);
 	}
+
+	Graph G(adjacency.GetVerticesAmount());
+	for (auto it = edges.begin(); it != edges.end(); ++it)
+		G.AddEdge(*it);
+	return G;
+}
+
+//  Components don't share vertices so threads mark different elements of visited.
+//  Threads take the next unprocessed component, edges are added to the forest in the order of components
+//  so the result doesn't depend on the threads
+Graph Graph::PrimMSF(double &length, unsigned int threadsAmount) const
+{
+	const GraphComponents &components = GetComponents();
+	unsigned int componentsAmount = components.GetComponentsAmount();
+	vector<char> visited(GetVerticesAmount(), 0);
+	vector<vector<Edge>> edges(componentsAmount);
+	vector<double> lengths(componentsAmount, 0.0);
+	atomic<unsigned int> nextComponent(0);
+
+	auto work = [&]()
+	{
+		for (unsigned int c = nextComponent++; c < componentsAmount; c = nextComponent++)
+			PrimComponent(m_EdgeList, components.GetRepresentative(c), components.GetComponentSize(c), visited, edges[c], lengths[c]);
+	};
+
+	vector<thread> threads;
+	for (unsigned int t = 1; t < threadsAmount && t < componentsAmount; ++t)
+		threads.push_back(thread(work));
+	work();
+	for (auto it = threads.begin(); it != threads.end(); ++it)
+		it->join();
+
+	//  In a directed Graph some vertices of a weak component may be unreachable from its representative.
+	//  Prim's algorithm starts again from each of them, edges to the trees built before are skipped as visited
+	for (unsigned int v = 0; v < GetVerticesAmount(); ++v)
+		if (!visited[v])
+		{
+			unsigned int c = components.GetComponent(v);
+			PrimComponent(m_EdgeList, v, components.GetComponentSize(c), visited, edges[c], lengths[c]);
+		}
+
+	Graph G(GetVerticesAmount());
+	length = 0;
+	for (unsigned int c = 0; c < componentsAmount; ++c)
+	{
+		for (auto it = edges[c].begin(); it != edges[c].end(); ++it)
+			G.AddEdge(*it);
+		length += lengths[c];
+	}
+	return G;
 }
 
 Path::Path(unsigned int start) : m_Weight(0.0)
@@ -286,6 +574,10 @@ Path::Path(const Path &path, const Edge &edge) : m_Path(path.m_Path)
 	m_Weight = path.m_Weight + edge.GetEdgeWeight();
 }
 
+Path::Path(const list<unsigned int> &path, double weight) : m_Path(path), m_Weight(weight)
+{
+}
+
 double Path::GetWeight() const
 {
 	return m_Weight;
@@ -317,7 +609,8 @@ void Path::AddVertex(const Edge &edge)
 	m_Weight += edge.GetEdgeWeight();
 }
 
-ShortestPathAlgorithm::ShortestPathAlgorithm() : m_CloseSet(), m_OpenSet()
+ShortestPathAlgorithm::ShortestPathAlgorithm() : m_CloseSet(), m_OpenSet(), m_KernelType(GetBestRelaxationKernelType()),
+	m_Relax(GetRelaxationKernel(m_KernelType))
 {
 }
 
@@ -328,24 +621,186 @@ ShortestPathAlgorithm::~ShortestPathAlgorithm()
 //  Check if the open set contains the vertex
 bool ShortestPathAlgorithm::OpenSetContains(unsigned int vertex) const
 {
-	for (auto it = m_OpenSet.begin(); it != m_OpenSet.end(); ++it)
-		if (*it == vertex)
-			return true;
-	return false;
+	return m_OpenSetFlags[vertex] != 0;
 }
 
-//  Get Shortest Path LENGTH from u to v
-double ShortestPathAlgorithm::GetShortestPathLength(const Graph& G, unsigned int u, unsigned int v)
+void ShortestPathAlgorithm::AddToOpenSet(unsigned int vertex)
+{
+	m_OpenSet.push_back(vertex);
+	m_OpenSetFlags[vertex] = 1;
+}
+
+//  The sets are cleared in full only when the amount of vertices changes. Otherwise only the distances of touched
+//  vertices and the flags of settled ones are reset so a search costs only the amount of vertices it reaches
+void ShortestPathAlgorithm::ResetSets(unsigned int verticesAmount)
 {
 	m_CloseSet = PriorityQueue<unsigned int, double>();
+	if (m_Distances.size() != verticesAmount)
+	{
+		m_OpenSetFlags.assign(verticesAmount, 0);
+		m_Distances.assign(verticesAmount, DBL_MAX);
+	}
+	else
+	{
+		for (auto it = m_OpenSet.begin(); it != m_OpenSet.end(); ++it)
+			m_OpenSetFlags[*it] = 0;
+		for (auto it = m_Touched.begin(); it != m_Touched.end(); ++it)
+			m_Distances[*it] = DBL_MAX;
+	}
 	m_OpenSet.resize(0);
+	m_Touched.resize(0);
+	//  predecessors are read only for reached vertices so they don't need to be reset
+	m_Predecessors.resize(verticesAmount);
+}
 
-	const list<Edge> &firstVNeighbors = G.GetNodeEdges(u);
-	//  Add u to the open set
-	m_OpenSet.push_back(u);
-	//  Add all the neighboors of u to the close set
-	for (auto it = firstVNeighbors.begin(); it != firstVNeighbors.end(); ++it)
-		m_CloseSet.Insert(it->GetEndVertexNumber(), it->GetEdgeWeight());
+void ShortestPathAlgorithm::StartSearch(unsigned int u)
+{
+	m_Distances[u] = 0.0;
+	m_Touched.push_back(u);
+	m_CloseSet.Insert(u, 0.0);
+}
+
+//  The kernel updates m_Distances itself so the close set gets only vertices whose distance became better.
+//  A vertex can be in the close set several times, only the first (the best) entry is processed
+void ShortestPathAlgorithm::RelaxEdges(const unsigned int *targets, const double *weights, unsigned int degree, unsigned int vertex, double distance)
+{
+	if (m_Improved.size() < degree)
+		m_Improved.resize(degree);
+
+	unsigned int improved = m_Relax(targets, weights, degree, distance, &m_Distances[0], &m_Improved[0]);
+	for (unsigned int i = 0; i < improved; ++i)
+	{
+		m_Predecessors[m_Improved[i]] = vertex;
+		m_Touched.push_back(m_Improved[i]);
+		m_CloseSet.Insert(m_Improved[i], m_Distances[m_Improved[i]]);
+	}
+}
+
+void ShortestPathAlgorithm::RelaxVertex(const AdjacencyArrays &arrays, unsigned int vertex, double distance)
+{
+	unsigned int degree = arrays.GetDegree(vertex);
+	if (degree > 0)
+		RelaxEdges(arrays.GetTargets(vertex), arrays.GetWeights(vertex), degree, vertex, distance);
+}
+
+//  Edges are decoded to arrays first so the same kernels are used
+void ShortestPathAlgorithm::RelaxVertex(const CompressedAdjacency &adjacency, unsigned int vertex, double distance)
+{
+	unsigned int degree = adjacency.GetDegree(vertex);
+	if (degree == 0)
+		return;
+
+	if (m_DecodedTargets.size() < degree)
+	{
+		m_DecodedTargets.resize(degree);
+		m_DecodedWeights.resize(degree);
+	}
+	adjacency.DecodeEdges(vertex, &m_DecodedTargets[0], &m_DecodedWeights[0]);
+	RelaxEdges(&m_DecodedTargets[0], &m_DecodedWeights[0], degree, vertex, distance);
+}
+
+RelaxationKernelType ShortestPathAlgorithm::GetRelaxationKernelType() const
+{
+	return m_KernelType;
+}
+
+void ShortestPathAlgorithm::SetRelaxationKernelType(RelaxationKernelType type)
+{
+	m_KernelType = IsRelaxationKernelSupported(type) ? type : RELAXATION_SCALAR;
+	m_Relax = GetRelaxationKernel(m_KernelType);
+}
+
+void ShortestPathAlgorithm::SetCacheLimit(size_t bytes)
+{
+	m_Cache.SetMemoryLimit(bytes);
+}
+
+const SearchCache &ShortestPathAlgorithm::GetCache() const
+{
+	return m_Cache;
+}
+
+Path ShortestPathAlgorithm::RestorePath(const vector<unsigned int> &predecessors, unsigned int u, unsigned int v, double weight)
+{
+	list<unsigned int> path;
+	for (unsigned int x = v; x != u; x = predecessors[x])
+		path.push_front(x);
+	path.push_front(u);
+	return Path(path, weight);
+}
+
+//  Swapping vectors doesn't copy them so switching between searches is O(1)
+void ShortestPathAlgorithm::SwapSets(SearchCache::Tree &tree)
+{
+	m_OpenSet.swap(tree.m_Settled);
+	m_OpenSetFlags.swap(tree.m_SettledFlags);
+	m_CloseSet.Swap(tree.m_Queue);
+	m_Distances.swap(tree.m_Distances);
+	m_Predecessors.swap(tree.m_Predecessors);
+}
+
+void ShortestPathAlgorithm::SettleUntil(const AdjacencyArrays &arrays, unsigned int v)
+{
+	while (!m_CloseSet.Empty())
+	{
+		unsigned int vertex = m_CloseSet.Top();
+		double priority = m_CloseSet.GetTopPriority();
+		m_CloseSet.Pop();
+
+		if (OpenSetContains(vertex))
+			continue;
+
+		AddToOpenSet(vertex);
+		RelaxVertex(arrays, vertex, priority);
+		if (vertex == v)
+			return;
+	}
+}
+
+//  The search is done in the sets of the algorithm: the tree is swapped in, goes on and is swapped back to the cache.
+//  Touched vertices of the own sets are put aside meanwhile, the ones of the tree are not needed (trees are never reset)
+const SearchCache::Tree &ShortestPathAlgorithm::CachedSearch(const Graph &G, unsigned int u, unsigned int v)
+{
+	SearchCache::Tree *pTree = m_Cache.Find(u, G.GetVersion());
+	if (pTree != NULL && (pTree->IsComplete() || (v != UINT_MAX && pTree->IsSettled(v))))
+	{
+		m_Cache.CountQuery(CACHED_QUERY_HIT);
+		return *pTree;
+	}
+
+	vector<unsigned int> touched;
+	m_Touched.swap(touched);
+	if (pTree != NULL)
+	{
+		m_Cache.CountQuery(CACHED_QUERY_RESUMED);
+		SwapSets(*pTree);
+	}
+	else
+	{
+		m_Cache.CountQuery(CACHED_QUERY_STARTED);
+		pTree = &m_Cache.Add(u, G.GetVersion());
+		SwapSets(*pTree);
+		ResetSets(G.GetVerticesAmount());
+		StartSearch(u);
+	}
+
+	SettleUntil(G.GetAdjacencyArrays(), v);
+	SwapSets(*pTree);
+	m_Touched.swap(touched);
+	m_Cache.Update(*pTree);
+	return *pTree;
+}
+
+//  Dijkstra search from u until v is reached. Returns -1 if there is no path
+template<typename TAdjacency>
+double ShortestPathAlgorithm::SearchLength(const TAdjacency &adjacency, unsigned int verticesAmount, unsigned int u, unsigned int v)
+{
+	ResetSets(verticesAmount);
+	if (u >= verticesAmount || v >= verticesAmount)
+		return -1;
+
+	//  Start from u itself
+	StartSearch(u);
 
 	//  While we can find a path from u to v
 	while (!m_CloseSet.Empty())
@@ -355,75 +810,49 @@ double ShortestPathAlgorithm::GetShortestPathLength(const Graph& G, unsigned int
 		double priority = m_CloseSet.GetTopPriority();
 		m_CloseSet.Pop();
 
+		//  If this vertex is in the open set there already is a shorter path to it
+		if (OpenSetContains(vertex))
+			continue;
+
 		//  If it is v we're over (Dijkstra algoritm guarantees this path's the shortest)
 		if (vertex == v)
 			return priority;
 
-		//  If this vertex is not in the open set (it equals there is no shorter path to this vertex)
-		if (!OpenSetContains(vertex))
-		{
-			m_OpenSet.push_back(vertex);
-
-			const list<Edge> & neighbors = G.GetNodeEdges(vertex);
-			for (auto it = neighbors.begin(); it != neighbors.end(); ++it)
-			{
-				if (!OpenSetContains(it->GetEndVertexNumber()))
-				{
-					//  Inserting the vertex if it is not in the queue already or
-					//  if its weight is less than a weight of another path to this vertex
-					//  (i.e. this path is better than any prior paths to this vertex found)
-					m_CloseSet.InsertIfPriorityLess(it->GetEndVertexNumber(), priority + it->GetEdgeWeight());
-				}
-			}
-		}
+		AddToOpenSet(vertex);
+		RelaxVertex(adjacency, vertex, priority);
 	}
 
 	return -1;
 }
 
-//  Get the AVERAGE of shortest paths from u to other vertices
-//  This method computes a shortest path from u to any vertex in the Graph
-//  Then it computes the average
-double ShortestPathAlgorithm::AverageShortestPath(const Graph &G, unsigned int u)
+//  Dijkstra search from u to all the vertices. Returns the average distance to the reached vertices
+template<typename TAdjacency>
+double ShortestPathAlgorithm::SearchAverage(const TAdjacency &adjacency, unsigned int verticesAmount, unsigned int u)
 {
-	m_CloseSet = PriorityQueue<unsigned int, double>();
-	m_OpenSet.resize(0);
+	ResetSets(verticesAmount);
+	if (u >= verticesAmount)
+		return -1.0;
 
 	double sum = 0.0;
-	const list<Edge> &firstVNeighbors = G.GetNodeEdges(u);
-	//  Add u to the open set
-	m_OpenSet.push_back(u);
-	//  Add all the neighboors of u to the close set
-	for (auto it = firstVNeighbors.begin(); it != firstVNeighbors.end(); ++it)
-		m_CloseSet.Insert(it->GetEndVertexNumber(), it->GetEdgeWeight());
+	//  Start from u itself. Its weight is 0 so it doesn't change the sum
+	StartSearch(u);
 
-	//  While we can find a path from u to v
+	//  While there are reachable vertices
 	while (!m_CloseSet.Empty())
 	{
-		//  Get the path with the best priority
+		//  Get the vertex with the best priority
 		unsigned int vertex = m_CloseSet.Top();
 		double priority = m_CloseSet.GetTopPriority();
 		m_CloseSet.Pop();
 
-		//  If this vertex is not in the open set (it equals there is no shorter path to this vertex)
-		if (!OpenSetContains(vertex))
-		{
-			m_OpenSet.push_back(vertex);
-			//  Add this weight to the sum
-			sum += priority;
+		//  If this vertex is in the open set there already is a shorter path to it
+		if (OpenSetContains(vertex))
+			continue;
 
-			const list<Edge> & neighbors = G.GetNodeEdges(vertex);
-			for (auto it = neighbors.begin(); it != neighbors.end(); ++it)
-			{
-				if (!OpenSetContains(it->GetEndVertexNumber()))  //  1. find 2. second check
-				{
-					//  Inserting the vertex if it is not in the queue already or
-					//  if its weight is less than a weight of another path to this vertex
-					//  (i.e. this path is better than any prior paths to this vertex found)
-					m_CloseSet.InsertIfPriorityLess(it->GetEndVertexNumber(), priority + it->GetEdgeWeight());
-				}
-			}
-		}
+		AddToOpenSet(vertex);
+		//  Add this weight to the sum
+		sum += priority;
+		RelaxVertex(adjacency, vertex, priority);
 	}
 
 	if (m_OpenSet.size() > 1)
@@ -432,55 +861,98 @@ double ShortestPathAlgorithm::AverageShortestPath(const Graph &G, unsigned int u
 		return -1.0;
 }
 
-//  Get Shortest PATH from u to v
-Path ShortestPathAlgorithm::GetShortestPath(const Graph &G, unsigned int u, unsigned int v)
+//  Get Shortest Path LENGTH from u to v
+double ShortestPathAlgorithm::GetShortestPathLength(const Graph& G, unsigned int u, unsigned int v)
 {
-	m_PathCloseSet = PriorityQueue<Path, double>();
-	m_OpenSet.resize(0);
+	//  Vertices in different components are rejected before the search
+	if (!G.GetComponents().MayReach(u, v))
+		return -1;
 
-	Path currentPath(u);
-	const list<Edge> &firstVNeighbors = G.GetNodeEdges(u);
-	//  Add u to the open set
-	m_OpenSet.push_back(u);
-	//  Add all the neighboors of u to the close set
-	for (auto it = firstVNeighbors.begin(); it != firstVNeighbors.end(); ++it)
+	if (m_Cache.IsEnabled())
 	{
-		Path nextPath(currentPath, *it);
-		m_PathCloseSet.Insert(nextPath, nextPath.GetWeight());
+		const SearchCache::Tree &tree = CachedSearch(G, u, v);
+		return tree.IsSettled(v) ? tree.m_Distances[v] : -1;
 	}
 
+	return SearchLength(G.GetAdjacencyArrays(), G.GetVerticesAmount(), u, v);
+}
+
+double ShortestPathAlgorithm::GetShortestPathLength(const CompressedAdjacency &adjacency, unsigned int u, unsigned int v)
+{
+	return SearchLength(adjacency, adjacency.GetVerticesAmount(), u, v);
+}
+
+//  Get the AVERAGE of shortest paths from u to other vertices
+//  This method computes a shortest path from u to any vertex in the Graph
+//  Then it computes the average
+double ShortestPathAlgorithm::AverageShortestPath(const Graph &G, unsigned int u)
+{
+	if (!m_Cache.IsEnabled() || u >= G.GetVerticesAmount())
+		return SearchAverage(G.GetAdjacencyArrays(), G.GetVerticesAmount(), u);
+
+	//  Distances are added in the order the vertices were settled so the sum is the same as SearchAverage's one
+	const SearchCache::Tree &tree = CachedSearch(G, u, UINT_MAX);
+	double sum = 0.0;
+	for (auto it = tree.m_Settled.begin(); it != tree.m_Settled.end(); ++it)
+		sum += tree.m_Distances[*it];
+
+	if (tree.m_Settled.size() > 1)
+		return sum / (tree.m_Settled.size() - 1);
+	else
+		return -1.0;
+}
+
+double ShortestPathAlgorithm::AverageShortestPath(const CompressedAdjacency &adjacency, unsigned int u)
+{
+	return SearchAverage(adjacency, adjacency.GetVerticesAmount(), u);
+}
+
+//  Get Shortest PATH from u to v
+Path ShortestPathAlgorithm::GetShortestPath(const Graph &G, unsigned int u, unsigned int v)
+{
+	if (!m_Cache.IsEnabled() || !G.GetComponents().MayReach(u, v))
+		return FindPath(G, u, v);
+
+	//  Predecessors of settled vertices are final so the path is restored from the tree
+	const SearchCache::Tree &tree = CachedSearch(G, u, v);
+	if (!tree.IsSettled(v))
+		return Path(u);
+	return RestorePath(tree.m_Predecessors, u, v, tree.m_Distances[v]);
+}
+
+//  It is the same search as in GetShortestPathLength but each improved vertex remembers the vertex it was reached from.
+//  When v is reached the path is restored by these predecessors
+Path ShortestPathAlgorithm::FindPath(const Graph &G, unsigned int u, unsigned int v)
+{
+	if (!G.GetComponents().MayReach(u, v))
+		return Path(u);
+
+	ResetSets(G.GetVerticesAmount());
+
+	const AdjacencyArrays &arrays = G.GetAdjacencyArrays();
+
+	//  Start from u itself
+	StartSearch(u);
+
 	//  While we can find a path from u to v
-	while (!m_PathCloseSet.Empty())
+	while (!m_CloseSet.Empty())
 	{
-		//  Get the path with the best priority
-		currentPath = m_PathCloseSet.Top();
-		double priority = m_PathCloseSet.GetTopPriority();
-		m_PathCloseSet.Pop();
+		//  Get the vertex with the best priority
+		unsigned int vertex = m_CloseSet.Top();
+		double priority = m_CloseSet.GetTopPriority();
+		m_CloseSet.Pop();
 
-		//  If it ends in v we're over (Dijkstra algoritm guarantees this path's the shortest)
-		if (currentPath.GetFinalVertex() == v)
-			return currentPath;
+		//  If this vertex is in the open set there already is a shorter path to it
+		if (OpenSetContains(vertex))
+			continue;
 
-		//  If this vertex is not in the open set (it equals there is no shorter path to this vertex)
-		if (!OpenSetContains(currentPath.GetFinalVertex()))
-		{
-			//  Add vertex to the open set
-			m_OpenSet.push_back(currentPath.GetFinalVertex());
+		//  If it is v we're over (Dijkstra algoritm guarantees this path's the shortest)
+		if (vertex == v)
+			return RestorePath(m_Predecessors, u, v, priority);
 
-			const list<Edge> & neighbors = G.GetNodeEdges(currentPath.GetFinalVertex());
-			for (auto it = neighbors.begin(); it != neighbors.end(); ++it)
-			{
-				if (!OpenSetContains(it->GetEndVertexNumber()))
-				{
-					//  Inserting the path if it is not in the queue already or
-					//  if its weight is less than a weight of another path to this vertex
-					//  (i.e. this path is better than any prior paths to this vertex found)
-					Path nextPath(currentPath, *it);
-					m_PathCloseSet.InsertIfPriorityLess(nextPath, nextPath.GetWeight());
-				}
-			}
-		}
+		AddToOpenSet(vertex);
+		RelaxVertex(arrays, vertex, priority);
 	}
 
 	return Path(u);
-}
\ No newline at end of file
+}
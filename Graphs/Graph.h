@@ -3,7 +3,13 @@
 #ifndef GRAPH_H__
 #define GRAPH_H__
 
+#include "Components.h"
 #include "PriorityQueue.h"
+#include "Relaxation.h"
+#include "SearchCache.h"
+#include <atomic>
+#include <cfloat>
+#include <climits>
 #include <cstdlib>
 #include <ctime>
 #include <vector>
@@ -11,9 +17,12 @@
 #include <utility>
 #include <string>
 #include <fstream>
+#include <mutex>
 
 using std::vector;
 using std::list;
+using std::atomic;
+using std::mutex;
 using std::pair;
 using std::string;
 using std::ifstream;
@@ -21,6 +30,8 @@ using std::ios_base;
 
 double GenerateRandomDouble(double dMin, double dMax);
 
+class CompressedAdjacency;
+
 //  This class implements an Edge TO a vertex with a given weight.
 //  It doesn't have to store a number of the FROM vertex because these Edges be stored in a list container
 //  which is linked with a FROM vertex by the index in the m_EdgeList vector member of the Graph class
@@ -45,6 +56,35 @@ public:
 	void SetEdgeWeight(double weight);
 };
 
+//  This class stores the Graph adjacency as a structure of arrays (the CSR format).
+//  Edges of the vertex v are stored at indexes [offset(v), offset(v + 1)) of the targets and weights arrays
+//  in the same order as in the adjacency list. Contiguous arrays let relaxation kernels load
+//  several edges at once instead of walking list nodes one by one
+class AdjacencyArrays
+{
+private:
+	vector<unsigned int> m_Offsets;
+	vector<unsigned int> m_Targets;
+	vector<double> m_Weights;
+public:
+	AdjacencyArrays();
+	//  Build arrays from adjacency lists
+	explicit AdjacencyArrays(const vector<list<Edge>> &edgeList);
+	~AdjacencyArrays();
+
+	//  Getters. Pointers are valid while the arrays are not rebuilt
+	unsigned int GetDegree(unsigned int v) const { return m_Offsets[v + 1] - m_Offsets[v]; }
+	const unsigned int *GetTargets(unsigned int v) const { return m_Targets.data() + m_Offsets[v]; }
+	const double *GetWeights(unsigned int v) const { return m_Weights.data() + m_Offsets[v]; }
+	//  Get the amount of memory used by the arrays in bytes
+	size_t GetMemoryUsage() const;
+	//  Get the arrays of the Graph with all edges reversed (edges of v are the edges coming to v)
+	AdjacencyArrays Reverse() const;
+	//  Change the weight of the first edge from v1 to v2 (the same edge Graph::SetEdgeValue changes).
+	//  Returns false if there is no such edge
+	bool SetWeight(unsigned int v1, unsigned int v2, double weight);
+};
+
 //  This class implements the Graph
 //  It uses adjacency list to represent Graph. Each element in the m_EdgeList vector
 //  represents a vertex. Index of the element equals the vertex number.
@@ -53,6 +93,31 @@ class Graph
 private:
 	vector<list<Edge>> m_EdgeList;
 	unsigned int m_EdgesAmount;
+	//  Graphs read from files are directed, generated ones are not
+	bool m_bDirected;
+	//  Structure of arrays copy of m_EdgeList. It is built on the first request and dropped when edges are added
+	//  or deleted. Weight changes are written to it in place
+	mutable AdjacencyArrays m_Arrays;
+	mutable atomic<bool> m_bArraysValid;
+	//  Arrays of the reversed edges of a directed Graph (undirected ones use m_Arrays). Kept in the same way
+	mutable AdjacencyArrays m_ReverseArrays;
+	mutable atomic<bool> m_bReverseArraysValid;
+	//  Components are found on the first request too. Changing weights doesn't change them
+	mutable GraphComponents m_Components;
+	mutable atomic<bool> m_bComponentsValid;
+	//  Lazy parts are built under this lock so concurrent queries build them once
+	mutable mutex m_CacheMutex;
+	//  Changed by any edge change. Versions are unique among all the Graphs so a version identifies the edges
+	unsigned long long m_Version;
+
+	//  Change the weight of the first edge from v1 to v2 in the list and in the arrays. Returns false if there is no such edge
+	bool SetListWeight(unsigned int v1, unsigned int v2, double value);
+	//  Prim's algorithm on the component of the start vertex (componentSize is the amount of its vertices).
+	//  Tree edges are appended to edges and their weights are added to length. Returns false if not
+	//  all the vertices of the component are reached (it is possible only in directed graphs)
+	template<typename TAdjacency>
+	static bool PrimComponent(const TAdjacency &adjacency, unsigned int start, unsigned int componentSize,
+							  vector<char> &visited, vector<Edge> &edges, double &length);
 public:
 	//  Construct a graph that does not have edges, only nodes.
 	//  explicit keyword because we don't want initializations like Graph g = 1; happen
@@ -63,6 +128,9 @@ public:
 	Graph(unsigned int size, double density, double distance_min, double distance_max);
 	//  Read graph from a file
 	Graph(const string &filename);
+	//  Copy the edges and the lazy parts built so far
+	Graph(const Graph &G);
+	Graph &operator=(const Graph &G);
 	//  The destructor
 	~Graph();
 
@@ -70,6 +138,10 @@ public:
 	unsigned int GetVerticesAmount() const;
 	//  Get the number of edges between vertices in the Graph
 	unsigned int GetEdgesAmount() const;
+	//  Check if the Graph is directed
+	bool IsDirected() const;
+	//  Get the version of the edges. It changes when edges are added, deleted or their weights are changed
+	unsigned long long GetVersion() const;
 	//  Isn't useful since we have node value == its number. But can be useful if we change this approach
 	unsigned int GetNodeValue(unsigned int v1) const;
 	//  Get edge weight by its vertices
@@ -78,10 +150,21 @@ public:
 	bool Adjacent(unsigned int v1, unsigned int v2) const;
 	//  Returns a vertex adjacency list. Return value is a const & because of performance reason
 	const list<Edge> &GetNodeEdges(unsigned int v) const;
+	//  Returns the adjacency as a structure of arrays. It is built lazily, concurrent queries may call it
+	//  (but edge changes must not run together with queries)
+	const AdjacencyArrays &GetAdjacencyArrays() const;
+	//  Returns the adjacency of the Graph with all edges reversed (edges of v are the edges coming to v).
+	//  It is built lazily in the same way. An undirected Graph is its own reverse so its arrays are returned
+	const AdjacencyArrays &GetReverseAdjacencyArrays() const;
+	//  Returns connected components of the Graph. They are found lazily in one thread
+	const GraphComponents &GetComponents() const;
+	//  Build the lazy parts now, the components are found with threadsAmount threads. It saves the first queries
+	//  from building them (e.g. call it before a server starts answering queries)
+	void BuildCaches(unsigned int threadsAmount) const;
 
 	//  Since we have node value == its number this function is empty. But it can be changed later
 	void SetNodeValue(unsigned int v1, double value);
-	//  Change edge weight
+	//  Change edge weight. Both directions of an edge of an undirected Graph are changed so it stays symmetric
 	void SetEdgeValue(unsigned int v1, unsigned int v2, double value);
 	//  Add an edge to the Graph
 	void AddEdge(unsigned int v1, unsigned int v2, double distance);
@@ -89,7 +172,14 @@ public:
 	//  Delete an edge from the Graph
 	void DeleteEdge(unsigned int v1, unsigned int v2);
 	//  Prim's algorithm. A tree is a graph so the result is of the Graph class
-	Graph PrimMST(double &length);
+	//  If the Graph is disconnected returns an empty Graph and length is DBL_MAX
+	Graph PrimMST(double &length) const;
+	//  Prim's algorithm over the compressed adjacency. Edges are decoded while the tree is built
+	static Graph PrimMST(const CompressedAdjacency &adjacency, double &length);
+	//  Minimum spanning forest: Prim's algorithm runs on every connected component,
+	//  threadsAmount components are processed in parallel. Every vertex is in the forest: in a directed Graph
+	//  vertices that can't be reached from the first vertex of their weak component get trees of their own
+	Graph PrimMSF(double &length, unsigned int threadsAmount = 1) const;
 };
 
 //  This class implements a path on the Graph
@@ -107,6 +197,8 @@ public:
 	Path(const Path &path);
 	//  Copy a path and add an edge to it (continue path)
 	Path(const Path &path, const Edge &edge);
+	//  Construct a path from the list of its vertices and its known weight
+	Path(const list<unsigned int> &path, double weight);
 
 	//  Get the path itself
 	const list<unsigned int> &GetPath() const;
@@ -124,10 +216,14 @@ public:
 
 //  This class implements Dijkstra shortest path algorithm.
 
-//  It stores a priority queue of vertices with their weight as the close set to find shortest path length
-//  and a priority queue of paths to get the shortest path itself (Path class)
+//  It stores a priority queue of vertices with their weight as the close set
+//  and the best known distances to vertices. The shortest path itself is restored
+//  by the predecessors of the vertices so paths are not copied during the search.
 //  It stores the list of vertices and their respectful weights as the open set.
 
+//  Edges are relaxed with a vectorized kernel over the Graph adjacency arrays (see Relaxation.h).
+//  The kernel is selected by the CPU features detection, all of them give the same results.
+
 //  This class has 3 different methods to get the Shortest Path Length, the Average Shortest Path Length and
 //  the Shortest Path. Implementation of all of them differs a little because of the performance issues
 //  For example, tests have shown that using this implementation of the average path length calculation gives more than 20%
@@ -136,21 +232,76 @@ class ShortestPathAlgorithm
 {
 private:
 	vector<unsigned int> m_OpenSet;
+	//  m_OpenSetFlags[v] != 0 if v is in the open set. It makes the open set check O(1)
+	vector<char> m_OpenSetFlags;
 	PriorityQueue<unsigned int, double> m_CloseSet;
-	PriorityQueue<Path, double> m_PathCloseSet;
+	//  The best known distances to vertices, the vertices they are reached from
+	//  and the buffer for vertices improved by the relaxation
+	vector<double> m_Distances;
+	vector<unsigned int> m_Predecessors;
+	vector<unsigned int> m_Improved;
+	//  Vertices whose distances were changed since the last reset (with repeats)
+	vector<unsigned int> m_Touched;
+	//  Edges of the compressed adjacency are decoded here before the relaxation
+	vector<unsigned int> m_DecodedTargets;
+	vector<double> m_DecodedWeights;
+	RelaxationKernelType m_KernelType;
+	RelaxationKernel m_Relax;
+	//  Searches kept between queries (disabled by default)
+	SearchCache m_Cache;
 
 	//  Check if the vertex is already is in the open set
 	bool OpenSetContains(unsigned int vertex) const;
+	//  Add the vertex to the open set
+	void AddToOpenSet(unsigned int vertex);
+	//  Clear all the sets before a new search on the Graph with the given amount of vertices
+	void ResetSets(unsigned int verticesAmount);
+	//  Start the search from u with the distance 0
+	void StartSearch(unsigned int u);
+	//  Relax all edges of the vertex with the given distance and insert improved vertices to the close set
+	void RelaxVertex(const AdjacencyArrays &arrays, unsigned int vertex, double distance);
+	void RelaxVertex(const CompressedAdjacency &adjacency, unsigned int vertex, double distance);
+	//  Relax the given edges of the vertex
+	void RelaxEdges(const unsigned int *targets, const double *weights, unsigned int degree, unsigned int vertex, double distance);
+	//  Searches behind GetShortestPathLength and AverageShortestPath. They are the same for any adjacency format
+	template<typename TAdjacency>
+	double SearchLength(const TAdjacency &adjacency, unsigned int verticesAmount, unsigned int u, unsigned int v);
+	template<typename TAdjacency>
+	double SearchAverage(const TAdjacency &adjacency, unsigned int verticesAmount, unsigned int u);
+	//  Dijkstra search of the path from u to v without the cache. Returns Path(u) if there is no path
+	Path FindPath(const Graph &G, unsigned int u, unsigned int v);
+	//  Restore the path from u to v of the given weight by predecessors
+	static Path RestorePath(const vector<unsigned int> &predecessors, unsigned int u, unsigned int v, double weight);
+	//  Exchange the sets with the state of the cached search
+	void SwapSets(SearchCache::Tree &tree);
+	//  Go on with the search in the sets until v is settled (UINT_MAX settles all the reachable vertices).
+	//  Unlike other searches v is relaxed too so the search can be resumed later
+	void SettleUntil(const AdjacencyArrays &arrays, unsigned int v);
+	//  Find the cached tree of u and make its search go on until v is settled
+	const SearchCache::Tree &CachedSearch(const Graph &G, unsigned int u, unsigned int v);
 public:
 	ShortestPathAlgorithm();
 	~ShortestPathAlgorithm();
 
+	//  Get the type of the relaxation kernel in use
+	RelaxationKernelType GetRelaxationKernelType() const;
+	//  Force the relaxation kernel (e.g. to compare kernels). Unsupported types fall back to the scalar kernel
+	void SetRelaxationKernelType(RelaxationKernelType type);
+
 	//  Get the shortest Path from the vertex u to the vertex v on the Graph G
 	Path GetShortestPath(const Graph &G, unsigned int u, unsigned int v);
 	//  Get the shortest Path Length from the vertex u to the vertex v on the Graph G
 	double GetShortestPathLength(const Graph& G, unsigned int u, unsigned int v);
+	double GetShortestPathLength(const CompressedAdjacency &adjacency, unsigned int u, unsigned int v);
 	//  Get the average shortest Path Length of the v u of the Graph G
 	double AverageShortestPath(const Graph &G, unsigned int u);
+	double AverageShortestPath(const CompressedAdjacency &adjacency, unsigned int u);
+
+	//  Keep searches on Graphs between queries using at most the given amount of bytes (0 disables the cache).
+	//  Repeated queries from the same source are answered from the kept search or resume it. Queries on
+	//  the compressed adjacency don't use the cache
+	void SetCacheLimit(size_t bytes);
+	const SearchCache &GetCache() const;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,504 @@
+///  Contains the hub labeling index implementation
+#include "HubLabels.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#ifdef _WIN32
+//  windows.h defines min and max macros otherwise
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using std::atomic;
+using std::max;
+using std::min;
+using std::ofstream;
+using std::stable_sort;
+
+//  The labels file starts with this header. Then for each direction there are offsets (verticesAmount + 1 numbers
+//  of 8 bytes), hubs and distances (labelsAmount numbers each). Offsets and distances start at a multiple of 8 bytes.
+//  Amounts of labels and offsets are 64-bit because labels of a big graph can have more than 4G hubs
+struct HubLabelsFileHeader
+{
+	char m_Magic[8];
+	unsigned int m_VerticesAmount;
+	unsigned int m_bDirected;
+	unsigned long long m_LabelsAmount[2];
+};
+
+static const char HubLabelsMagic[8] = { 'G', 'R', 'P', 'H', 'H', 'U', 'B', '2' };
+
+//  Get positions of offsets, hubs and distances of each direction in the file. Returns the file size or 0 if
+//  the amounts of the header are too big for any file. The size is counted in 64 bits so it can't wrap around
+//  and match the size of a file (positions fit size_t if the size does)
+static unsigned long long GetFileLayout(const HubLabelsFileHeader &header, size_t positions[2][3])
+{
+	unsigned long long position = sizeof(HubLabelsFileHeader);
+	unsigned int directions = header.m_bDirected ? 2 : 1;
+	for (unsigned int d = 0; d < directions; ++d)
+	{
+		if (header.m_LabelsAmount[d] > ULLONG_MAX / 32)
+			return 0;
+		positions[d][0] = static_cast<size_t>(position);
+		position += (static_cast<unsigned long long>(header.m_VerticesAmount) + 1) * sizeof(unsigned long long);
+		positions[d][1] = static_cast<size_t>(position);
+		position += header.m_LabelsAmount[d] * sizeof(unsigned int);
+		position = (position + 7) / 8 * 8;
+		positions[d][2] = static_cast<size_t>(position);
+		position += header.m_LabelsAmount[d] * sizeof(double);
+	}
+	return position;
+}
+
+//  Offsets of a direction must start with 0, never decrease and end with the amount of its labels,
+//  otherwise a query could read out of the file
+static bool ValidateOffsets(const unsigned long long *offsets, unsigned int verticesAmount, unsigned long long labelsAmount)
+{
+	if (offsets[0] != 0 || offsets[verticesAmount] != labelsAmount)
+		return false;
+	for (unsigned int v = 0; v < verticesAmount; ++v)
+		if (offsets[v] > offsets[v + 1])
+			return false;
+	return true;
+}
+
+//  Buffers of one construction thread
+class HubLabelsWorker
+{
+public:
+	vector<double> m_Distances;
+	vector<char> m_Settled;
+	//  Distances between the current hub and the hubs of its label, by hub numbers
+	vector<double> m_HubDistances;
+	vector<unsigned int> m_Touched;
+	vector<unsigned int> m_Improved;
+	PriorityQueue<unsigned int, double> m_Queue;
+
+	explicit HubLabelsWorker(unsigned int verticesAmount) : m_Distances(verticesAmount, DBL_MAX), m_Settled(verticesAmount, 0),
+		m_HubDistances(verticesAmount, DBL_MAX) { }
+
+	//  Pruned Dijkstra search from the root. A vertex is skipped (and the search doesn't go through it) if the labels
+	//  already give a path not longer than the found one: some hub of rootLabel plus some hub of labels[x]
+	void Search(const AdjacencyArrays &adjacency, RelaxationKernel relax, unsigned int root, const vector<pair<unsigned int, double>> &rootLabel,
+				const vector<vector<pair<unsigned int, double>>> &labels, vector<pair<unsigned int, double>> &found);
+};
+
+void HubLabelsWorker::Search(const AdjacencyArrays &adjacency, RelaxationKernel relax, unsigned int root, const vector<pair<unsigned int, double>> &rootLabel,
+							 const vector<vector<pair<unsigned int, double>>> &labels, vector<pair<unsigned int, double>> &found)
+{
+	found.resize(0);
+	for (auto it = rootLabel.begin(); it != rootLabel.end(); ++it)
+		m_HubDistances[it->first] = it->second;
+
+	m_Distances[root] = 0.0;
+	m_Touched.push_back(root);
+	m_Queue.Insert(root, 0.0);
+	while (!m_Queue.Empty())
+	{
+		unsigned int vertex = m_Queue.Top();
+		double distance = m_Queue.GetTopPriority();
+		m_Queue.Pop();
+		if (m_Settled[vertex])
+			continue;
+		m_Settled[vertex] = 1;
+
+		bool bCovered = false;
+		const vector<pair<unsigned int, double>> &label = labels[vertex];
+		for (auto it = label.begin(); it != label.end() && !bCovered; ++it)
+			bCovered = m_HubDistances[it->first] != DBL_MAX && m_HubDistances[it->first] + it->second <= distance;
+		if (bCovered)
+			continue;
+
+		found.push_back(pair<unsigned int, double>(vertex, distance));
+		unsigned int degree = adjacency.GetDegree(vertex);
+		if (degree == 0)
+			continue;
+		if (m_Improved.size() < degree)
+			m_Improved.resize(degree);
+		unsigned int improved = relax(adjacency.GetTargets(vertex), adjacency.GetWeights(vertex), degree, distance, &m_Distances[0], &m_Improved[0]);
+		for (unsigned int i = 0; i < improved; ++i)
+		{
+			m_Touched.push_back(m_Improved[i]);
+			m_Queue.Insert(m_Improved[i], m_Distances[m_Improved[i]]);
+		}
+	}
+
+	//  The buffers are shared by all the searches of the worker so what this one has changed is restored
+	for (auto it = m_Touched.begin(); it != m_Touched.end(); ++it)
+	{
+		m_Distances[*it] = DBL_MAX;
+		m_Settled[*it] = 0;
+	}
+	m_Touched.resize(0);
+	for (auto it = rootLabel.begin(); it != rootLabel.end(); ++it)
+		m_HubDistances[it->first] = DBL_MAX;
+}
+
+HubLabels::HubLabels() : m_VerticesAmount(0), m_bDirected(false), m_pMapping(NULL), m_MappingSize(0)
+#ifdef _WIN32
+	, m_hFile(INVALID_HANDLE_VALUE), m_hMapping(NULL)
+#endif
+{
+	memset(&m_OutLabels, 0, sizeof(m_OutLabels));
+	memset(&m_InLabels, 0, sizeof(m_InLabels));
+}
+
+HubLabels::~HubLabels()
+{
+	Clear();
+}
+
+void HubLabels::Clear()
+{
+	if (m_pMapping != NULL)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(m_pMapping);
+		CloseHandle(m_hMapping);
+		CloseHandle(m_hFile);
+		m_hMapping = NULL;
+		m_hFile = INVALID_HANDLE_VALUE;
+#else
+		munmap(m_pMapping, m_MappingSize);
+#endif
+		m_pMapping = NULL;
+		m_MappingSize = 0;
+	}
+
+	for (int d = 0; d < 2; ++d)
+	{
+		m_Offsets[d].clear();
+		m_Hubs[d].clear();
+		m_Distances[d].clear();
+	}
+	m_VerticesAmount = 0;
+	m_bDirected = false;
+	memset(&m_OutLabels, 0, sizeof(m_OutLabels));
+	memset(&m_InLabels, 0, sizeof(m_InLabels));
+}
+
+void HubLabels::SetLabelsToArrays()
+{
+	LabelSet *sets[2] = { &m_OutLabels, &m_InLabels };
+	for (int d = 0; d < 2; ++d)
+	{
+		int source = m_bDirected ? d : 0;
+		sets[d]->m_Offsets = m_Offsets[source].data();
+		sets[d]->m_Hubs = m_Hubs[source].data();
+		sets[d]->m_Distances = m_Distances[source].data();
+	}
+}
+
+//  Hubs are numbered in the order they are processed so labels are sorted by appending.
+//  The direction 0 is "from a vertex to hubs" and the direction 1 is "from hubs to a vertex" (directed graphs only).
+//  A forward search from a hub finds distances from it so it fills the direction 1, a backward search fills the direction 0
+void HubLabels::Build(const Graph &G, unsigned int threadsAmount)
+{
+	Clear();
+	m_VerticesAmount = G.GetVerticesAmount();
+	m_bDirected = G.IsDirected();
+	if (threadsAmount == 0)
+		threadsAmount = 1;
+
+	const AdjacencyArrays &forward = G.GetAdjacencyArrays();
+	const AdjacencyArrays &backward = G.GetReverseAdjacencyArrays();
+
+	//  Vertices with more edges lie on more shortest paths so they become hubs first
+	vector<pair<unsigned int, unsigned int>> order(m_VerticesAmount);
+	for (unsigned int v = 0; v < m_VerticesAmount; ++v)
+		order[v] = pair<unsigned int, unsigned int>(UINT_MAX - forward.GetDegree(v) - (m_bDirected ? backward.GetDegree(v) : 0), v);
+	stable_sort(order.begin(), order.end());
+
+	unsigned int outDirection = 0, inDirection = m_bDirected ? 1 : 0;
+	vector<vector<pair<unsigned int, double>>> labels[2];
+	labels[0].resize(m_VerticesAmount);
+	if (m_bDirected)
+		labels[1].resize(m_VerticesAmount);
+
+	//  Vertices found by the searches of a batch are kept by hubs until the whole batch is done
+	//  so threads don't write to the labels while others read them
+	unsigned int maxBatchSize = threadsAmount == 1 ? 1 : threadsAmount * 4;
+	vector<vector<pair<unsigned int, double>>> found[2];
+	found[0].resize(maxBatchSize);
+	found[1].resize(maxBatchSize);
+
+	RelaxationKernel relax = GetRelaxationKernel(GetBestRelaxationKernelType());
+	vector<HubLabelsWorker> workers(threadsAmount, HubLabelsWorker(m_VerticesAmount));
+	unsigned int batch = 0, batchSize = 0;
+	atomic<unsigned int> nextHub(0);
+	auto work = [&](unsigned int w)
+	{
+		for (unsigned int h = nextHub++; h < batchSize; h = nextHub++)
+		{
+			unsigned int root = order[batch + h].second;
+			workers[w].Search(forward, relax, root, labels[outDirection][root], labels[inDirection], found[inDirection][h]);
+			if (m_bDirected)
+				workers[w].Search(backward, relax, root, labels[inDirection][root], labels[outDirection], found[outDirection][h]);
+		}
+	};
+
+	//  Threads live during the whole construction, every batch is a round of the pool
+	WorkerPool pool(threadsAmount);
+	for (; batch < m_VerticesAmount; batch += batchSize)
+	{
+		batchSize = min(maxBatchSize, m_VerticesAmount - batch);
+		nextHub = 0;
+		pool.Run(work);
+
+		//  Hubs of the batch are added in their order so labels stay sorted
+		for (unsigned int h = 0; h < batchSize; ++h)
+			for (unsigned int d = 0; d < (m_bDirected ? 2u : 1u); ++d)
+				for (auto it = found[d][h].begin(); it != found[d][h].end(); ++it)
+					labels[d][it->first].push_back(pair<unsigned int, double>(batch + h, it->second));
+	}
+
+	for (unsigned int d = 0; d < (m_bDirected ? 2u : 1u); ++d)
+	{
+		m_Offsets[d].assign(1, 0);
+		for (unsigned int v = 0; v < m_VerticesAmount; ++v)
+		{
+			for (auto it = labels[d][v].begin(); it != labels[d][v].end(); ++it)
+			{
+				m_Hubs[d].push_back(it->first);
+				m_Distances[d].push_back(it->second);
+			}
+			m_Offsets[d].push_back(m_Hubs[d].size());
+			//  free the memory as soon as possible, labels of big graphs take much of it
+			vector<pair<unsigned int, double>>().swap(labels[d][v]);
+		}
+	}
+	SetLabelsToArrays();
+}
+
+bool HubLabels::Save(const string &filename) const
+{
+	//  nothing is built or loaded
+	if (m_OutLabels.m_Offsets == NULL)
+		return false;
+
+	HubLabelsFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.m_Magic, HubLabelsMagic, sizeof(HubLabelsMagic));
+	header.m_VerticesAmount = m_VerticesAmount;
+	header.m_bDirected = m_bDirected ? 1 : 0;
+	const LabelSet *sets[2] = { &m_OutLabels, &m_InLabels };
+	for (unsigned int d = 0; d < (m_bDirected ? 2u : 1u); ++d)
+		header.m_LabelsAmount[d] = sets[d]->m_Offsets[m_VerticesAmount];
+
+	size_t positions[2][3];
+	size_t size = static_cast<size_t>(GetFileLayout(header, positions));
+	ofstream fout(filename, ios_base::out | ios_base::binary);
+	if (!fout.good())
+		return false;
+
+	//  Sections are written in the order of their positions, the gaps are filled with zeros
+	const char zeros[8] = { 0 };
+	fout.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	size_t position = sizeof(header);
+	for (unsigned int d = 0; d < (m_bDirected ? 2u : 1u); ++d)
+	{
+		const void *sections[3] = { sets[d]->m_Offsets, sets[d]->m_Hubs, sets[d]->m_Distances };
+		size_t sizes[3] = { (static_cast<size_t>(m_VerticesAmount) + 1) * sizeof(unsigned long long),
+			static_cast<size_t>(header.m_LabelsAmount[d]) * sizeof(unsigned int), static_cast<size_t>(header.m_LabelsAmount[d]) * sizeof(double) };
+		for (int i = 0; i < 3; ++i)
+		{
+			fout.write(zeros, positions[d][i] - position);
+			if (sizes[i] > 0)
+				fout.write(static_cast<const char *>(sections[i]), sizes[i]);
+			position = positions[d][i] + sizes[i];
+		}
+	}
+	fout.write(zeros, size - position);
+	return fout.good();
+}
+
+bool HubLabels::Load(const string &filename)
+{
+	Clear();
+
+	size_t fileSize = 0;
+	void *pMapping = NULL;
+#ifdef _WIN32
+	HANDLE hFile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER size;
+	HANDLE hMapping = NULL;
+	if (GetFileSizeEx(hFile, &size) && size.QuadPart > 0)
+		hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (hMapping != NULL)
+		pMapping = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+	if (pMapping == NULL)
+	{
+		if (hMapping != NULL)
+			CloseHandle(hMapping);
+		CloseHandle(hFile);
+		return false;
+	}
+	fileSize = static_cast<size_t>(size.QuadPart);
+	m_hFile = hFile;
+	m_hMapping = hMapping;
+#else
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat info;
+	if (fstat(fd, &info) == 0 && info.st_size > 0)
+	{
+		fileSize = static_cast<size_t>(info.st_size);
+		pMapping = mmap(NULL, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+		if (pMapping == MAP_FAILED)
+			pMapping = NULL;
+	}
+	//  the mapping stays valid after the file is closed
+	close(fd);
+	if (pMapping == NULL)
+		return false;
+#endif
+	m_pMapping = pMapping;
+	m_MappingSize = fileSize;
+
+	const char *data = static_cast<const char *>(m_pMapping);
+	HubLabelsFileHeader header;
+	size_t positions[2][3];
+	if (fileSize < sizeof(header))
+	{
+		Clear();
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.m_Magic, HubLabelsMagic, sizeof(HubLabelsMagic)) != 0 || GetFileLayout(header, positions) != fileSize)
+	{
+		Clear();
+		return false;
+	}
+
+	m_VerticesAmount = header.m_VerticesAmount;
+	m_bDirected = header.m_bDirected != 0;
+	LabelSet *sets[2] = { &m_OutLabels, &m_InLabels };
+	for (int d = 0; d < 2; ++d)
+	{
+		int source = m_bDirected ? d : 0;
+		sets[d]->m_Offsets = reinterpret_cast<const unsigned long long *>(data + positions[source][0]);
+		sets[d]->m_Hubs = reinterpret_cast<const unsigned int *>(data + positions[source][1]);
+		sets[d]->m_Distances = reinterpret_cast<const double *>(data + positions[source][2]);
+		if (!ValidateOffsets(sets[d]->m_Offsets, m_VerticesAmount, header.m_LabelsAmount[source]))
+		{
+			Clear();
+			return false;
+		}
+	}
+	return true;
+}
+
+//  Merge of two sorted lists of hubs
+double HubLabels::GetShortestPathLength(unsigned int u, unsigned int v) const
+{
+	if (u >= m_VerticesAmount || v >= m_VerticesAmount)
+		return -1;
+
+	const unsigned int *uHubs = m_OutLabels.m_Hubs + m_OutLabels.m_Offsets[u];
+	const unsigned int *uHubsEnd = m_OutLabels.m_Hubs + m_OutLabels.m_Offsets[u + 1];
+	const double *uDistances = m_OutLabels.m_Distances + m_OutLabels.m_Offsets[u];
+	const unsigned int *vHubs = m_InLabels.m_Hubs + m_InLabels.m_Offsets[v];
+	const unsigned int *vHubsEnd = m_InLabels.m_Hubs + m_InLabels.m_Offsets[v + 1];
+	const double *vDistances = m_InLabels.m_Distances + m_InLabels.m_Offsets[v];
+
+	double best = DBL_MAX;
+	while (uHubs != uHubsEnd && vHubs != vHubsEnd)
+	{
+		if (*uHubs == *vHubs)
+		{
+			best = min(best, *uDistances + *vDistances);
+			++uHubs, ++uDistances;
+			++vHubs, ++vDistances;
+		}
+		else if (*uHubs < *vHubs)
+			++uHubs, ++uDistances;
+		else
+			++vHubs, ++vDistances;
+	}
+
+	return best == DBL_MAX ? -1 : best;
+}
+
+//  Both distances are sums of the same edge weights in another order so a relative error of 1e-9 is allowed
+bool HubLabels::Validate(const Graph &G, unsigned int pairsAmount) const
+{
+	if (G.GetVerticesAmount() != m_VerticesAmount)
+		return false;
+	if (m_VerticesAmount == 0)
+		return true;
+
+	ShortestPathAlgorithm spa;
+	for (unsigned int i = 0; i < pairsAmount; ++i)
+	{
+		unsigned int u = rand() % m_VerticesAmount;
+		unsigned int v = rand() % m_VerticesAmount;
+		double expected = spa.GetShortestPathLength(G, u, v);
+		double length = GetShortestPathLength(u, v);
+		if ((expected < 0) != (length < 0) || fabs(expected - length) > 1e-9 * max(1.0, expected))
+			return false;
+	}
+	return true;
+}
+
+unsigned int HubLabels::GetVerticesAmount() const
+{
+	return m_VerticesAmount;
+}
+
+size_t HubLabels::GetLabelsAmount() const
+{
+	if (m_VerticesAmount == 0)
+		return 0;
+
+	size_t amount = static_cast<size_t>(m_OutLabels.m_Offsets[m_VerticesAmount]);
+	if (m_bDirected)
+		amount += static_cast<size_t>(m_InLabels.m_Offsets[m_VerticesAmount]);
+	return amount;
+}
+
+double HubLabels::GetAverageLabelSize() const
+{
+	return m_VerticesAmount > 0 ? static_cast<double>(GetLabelsAmount()) / m_VerticesAmount : 0.0;
+}
+
+unsigned int HubLabels::GetMaxLabelSize() const
+{
+	unsigned int maxSize = 0;
+	for (unsigned int v = 0; v < m_VerticesAmount; ++v)
+	{
+		//  a label has less hubs than there are vertices
+		unsigned int size = static_cast<unsigned int>(m_OutLabels.m_Offsets[v + 1] - m_OutLabels.m_Offsets[v]);
+		if (m_bDirected)
+			size += static_cast<unsigned int>(m_InLabels.m_Offsets[v + 1] - m_InLabels.m_Offsets[v]);
+		maxSize = max(maxSize, size);
+	}
+	return maxSize;
+}
+
+size_t HubLabels::GetMemoryUsage() const
+{
+	HubLabelsFileHeader header;
+	memset(&header, 0, sizeof(header));
+	header.m_VerticesAmount = m_VerticesAmount;
+	header.m_bDirected = m_bDirected ? 1 : 0;
+	if (m_OutLabels.m_Offsets != NULL)
+	{
+		header.m_LabelsAmount[0] = m_OutLabels.m_Offsets[m_VerticesAmount];
+		if (m_bDirected)
+			header.m_LabelsAmount[1] = m_InLabels.m_Offsets[m_VerticesAmount];
+	}
+
+	size_t positions[2][3];
+	return static_cast<size_t>(GetFileLayout(header, positions));
+}
@@ -0,0 +1,92 @@
+///  Contains the hub labeling index declaration
+
+#ifndef HUB_LABELS_H__
+#define HUB_LABELS_H__
+
+#include "Graph.h"
+
+//  This class implements the hub labeling distance index built by the pruned landmark labeling.
+
+//  Every vertex v gets a label: a list of hubs with distances from v to them (and for directed graphs the
+//  second list with distances from hubs to v). Labels cover all the shortest paths: for any u and v
+//  there is a hub on a shortest path from u to v that is in the labels of both. So the distance is
+//  the minimum of d(u, hub) + d(hub, v) over common hubs and it is found by merging two sorted arrays
+//  without a traversal of the Graph.
+
+//  Vertices are made hubs in the order of their degrees. A Dijkstra search from a new hub doesn't
+//  go further than vertices whose distance is already covered by the labels of the previous hubs,
+//  that keeps labels small. Several hubs can be processed in parallel: hubs are taken in batches
+//  (4 per thread) and threads take hubs of a batch one by one so a long search doesn't hold others. Hubs of one batch
+//  don't see the labels of each other so labels may be a bit bigger but they are still correct.
+
+//  Labels are stored as arrays (hub numbers and distances separately) so they can be saved to a file
+//  and mapped to memory later without any parsing
+class HubLabels
+{
+private:
+	//  Labels of one direction. Hubs of v are at [m_Offsets[v], m_Offsets[v + 1]) sorted by hub numbers
+	struct LabelSet
+	{
+		const unsigned long long *m_Offsets;
+		const unsigned int *m_Hubs;
+		const double *m_Distances;
+	};
+
+	unsigned int m_VerticesAmount;
+	bool m_bDirected;
+	//  From vertices to hubs and from hubs to vertices. They are the same labels for undirected graphs
+	LabelSet m_OutLabels;
+	LabelSet m_InLabels;
+
+	//  Arrays of the labels built in memory
+	vector<unsigned long long> m_Offsets[2];
+	vector<unsigned int> m_Hubs[2];
+	vector<double> m_Distances[2];
+
+	//  The mapped file of the labels loaded from a file
+	void *m_pMapping;
+	size_t m_MappingSize;
+#ifdef _WIN32
+	void *m_hFile;
+	void *m_hMapping;
+#endif
+
+	//  Labels point to their arrays so they can't be copied
+	HubLabels(const HubLabels &labels);
+	HubLabels &operator=(const HubLabels &labels);
+
+	//  Unmap the file and drop the labels
+	void Clear();
+	//  Point the label sets to the arrays built in memory
+	void SetLabelsToArrays();
+public:
+	HubLabels();
+	~HubLabels();
+
+	//  Build labels of the Graph using threadsAmount threads
+	void Build(const Graph &G, unsigned int threadsAmount = 1);
+	//  Save labels to the binary file. Returns false if the file can't be written
+	bool Save(const string &filename) const;
+	//  Map labels saved by Save to memory. Returns false if the file can't be mapped or is not a labels file
+	bool Load(const string &filename);
+
+	//  Get Shortest Path Length from u to v. Returns -1 if there is no path (like ShortestPathAlgorithm does).
+	//  The length is d(u, hub) + d(hub, v) so it can differ from the Dijkstra result in the last bits
+	double GetShortestPathLength(unsigned int u, unsigned int v) const;
+	//  Compare distances of pairsAmount random pairs with Dijkstra on the Graph the labels were built on.
+	//  Returns false if some of them differ by more than the rounding error
+	bool Validate(const Graph &G, unsigned int pairsAmount) const;
+
+	//  Statistics
+	unsigned int GetVerticesAmount() const;
+	//  Get the total amount of hubs in all labels
+	size_t GetLabelsAmount() const;
+	//  Get the average amount of hubs in the label of a vertex (both directions together)
+	double GetAverageLabelSize() const;
+	//  Get the largest amount of hubs in the label of a vertex (both directions together)
+	unsigned int GetMaxLabelSize() const;
+	//  Get the size of the labels in bytes (the same as the size of the file)
+	size_t GetMemoryUsage() const;
+};
+
+#endif
@@ -0,0 +1,284 @@
+///  Contains the k shortest loopless paths algorithm implementation
+#include "KShortestPaths.h"
+#include "WorkerPool.h"
+#include <algorithm>
+
+using std::equal;
+using std::find;
+using std::min;
+using std::reverse;
+
+const double KShortestPathsAlgorithm::PotentialsRadius = 2.0;
+
+KShortestPathsAlgorithm::KShortestPathsAlgorithm(unsigned int threadsAmount) : m_Workers(threadsAmount > 0 ? threadsAmount : 1),
+	m_PotentialsBound(DBL_MAX), m_Relax(GetRelaxationKernel(GetBestRelaxationKernelType()))
+{
+}
+
+KShortestPathsAlgorithm::~KShortestPathsAlgorithm()
+{
+}
+
+//  A vertex is settled when it is taken from the queue with the priority equal to its distance. Other entries are old ones.
+//  When the search stops all the vertices closer than the bound are settled, so the bound is not more than
+//  the distance of any other vertex. Tentative distances of reached but not settled vertices are not less than the bound too
+void KShortestPathsAlgorithm::FindPotentials(const AdjacencyArrays &backward, unsigned int u, unsigned int v)
+{
+	SpurSearch &search = m_Workers[0];
+	for (auto it = m_PotentialsTouched.begin(); it != m_PotentialsTouched.end(); ++it)
+		m_Potentials[*it] = DBL_MAX;
+	m_PotentialsTouched.resize(0);
+
+	m_PotentialsBound = DBL_MAX;
+	m_Potentials[v] = 0.0;
+	m_PotentialsTouched.push_back(v);
+	search.m_Queue.Insert(v, 0.0);
+	while (!search.m_Queue.Empty())
+	{
+		unsigned int vertex = search.m_Queue.Top();
+		double distance = search.m_Queue.GetTopPriority();
+		if (distance > m_PotentialsBound)
+			break;
+		search.m_Queue.Pop();
+		if (distance != m_Potentials[vertex])
+			continue;
+		if (vertex == u)
+			m_PotentialsBound = distance * PotentialsRadius;
+
+		unsigned int degree = backward.GetDegree(vertex);
+		if (degree == 0)
+			continue;
+		if (search.m_Improved.size() < degree)
+			search.m_Improved.resize(degree);
+		unsigned int improved = m_Relax(backward.GetTargets(vertex), backward.GetWeights(vertex), degree, distance, &m_Potentials[0],
+										&search.m_Improved[0]);
+		for (unsigned int i = 0; i < improved; ++i)
+		{
+			m_PotentialsTouched.push_back(search.m_Improved[i]);
+			search.m_Queue.Insert(search.m_Improved[i], m_Potentials[search.m_Improved[i]]);
+		}
+	}
+
+	if (search.m_Queue.Empty())
+		m_PotentialsBound = DBL_MAX;
+	search.m_Queue = PriorityQueue<unsigned int, double>();
+}
+
+double KShortestPathsAlgorithm::GetPotential(unsigned int vertex) const
+{
+	return min(m_Potentials[vertex], m_PotentialsBound);
+}
+
+//  The priority of a vertex is its distance plus its potential. The queue may keep old entries of a vertex,
+//  an entry is used only if its priority is the current one. A vertex whose distance gets better after it was
+//  expanded is expanded again so the result is exact with potentials that are only lower bounds (the bound
+//  of unsettled vertices makes them inconsistent, rounding can do it too).
+//  Distances are summed from startDistance along the path so the weight is the same as if the whole path were searched
+bool KShortestPathsAlgorithm::Search(SpurSearch &search, const AdjacencyArrays &arrays, const vector<unsigned int> &root, size_t spurIndex,
+									 unsigned int v, double startDistance, PathInfo &result)
+{
+	unsigned int spur = root[spurIndex];
+	//  No candidate distance is less than -DBL_MAX so root vertices are never reached
+	for (size_t i = 0; i < spurIndex; ++i)
+	{
+		search.m_Distances[root[i]] = -DBL_MAX;
+		search.m_Touched.push_back(root[i]);
+	}
+	search.m_Distances[spur] = startDistance;
+	search.m_Touched.push_back(spur);
+	search.m_Queue.Insert(spur, startDistance + GetPotential(spur));
+
+	bool bFound = false;
+	while (!search.m_Queue.Empty())
+	{
+		unsigned int vertex = search.m_Queue.Top();
+		double priority = search.m_Queue.GetTopPriority();
+		search.m_Queue.Pop();
+
+		double distance = search.m_Distances[vertex];
+		if (priority != distance + GetPotential(vertex))
+			continue;
+		if (vertex == v)
+		{
+			bFound = true;
+			break;
+		}
+
+		unsigned int degree = arrays.GetDegree(vertex);
+		if (degree == 0)
+			continue;
+		if (search.m_Improved.size() < degree)
+			search.m_Improved.resize(degree);
+
+		const unsigned int *targets = arrays.GetTargets(vertex);
+		const double *weights = arrays.GetWeights(vertex);
+		unsigned int improved = 0;
+		if (vertex == spur && !search.m_BannedTargets.empty())
+		{
+			for (unsigned int i = 0; i < degree; ++i)
+			{
+				double candidate = distance + weights[i];
+				if (candidate < search.m_Distances[targets[i]] &&
+					find(search.m_BannedTargets.begin(), search.m_BannedTargets.end(), targets[i]) == search.m_BannedTargets.end())
+				{
+					search.m_Distances[targets[i]] = candidate;
+					search.m_Improved[improved++] = targets[i];
+				}
+			}
+		}
+		else
+			improved = m_Relax(targets, weights, degree, distance, &search.m_Distances[0], &search.m_Improved[0]);
+
+		for (unsigned int i = 0; i < improved; ++i)
+		{
+			unsigned int target = search.m_Improved[i];
+			search.m_Predecessors[target] = vertex;
+			search.m_Touched.push_back(target);
+			//  the end can't be reached from vertices without potentials
+			double potential = GetPotential(target);
+			if (potential != DBL_MAX)
+				search.m_Queue.Insert(target, search.m_Distances[target] + potential);
+		}
+	}
+
+	if (bFound)
+	{
+		size_t rootSize = result.m_Vertices.size();
+		for (unsigned int x = v; x != spur; x = search.m_Predecessors[x])
+		{
+			result.m_Vertices.push_back(x);
+			result.m_Distances.push_back(search.m_Distances[x]);
+		}
+		result.m_Vertices.push_back(spur);
+		result.m_Distances.push_back(startDistance);
+		reverse(result.m_Vertices.begin() + rootSize, result.m_Vertices.end());
+		reverse(result.m_Distances.begin() + rootSize, result.m_Distances.end());
+	}
+
+	for (auto it = search.m_Touched.begin(); it != search.m_Touched.end(); ++it)
+		search.m_Distances[*it] = DBL_MAX;
+	search.m_Touched.resize(0);
+	search.m_Queue = PriorityQueue<unsigned int, double>();
+	return bFound;
+}
+
+//  The root path is the beginning of the last found path up to the spur vertex. It is hidden (except the spur vertex)
+//  so the result is loopless. The edges going out of the spur vertex along every found path with the same root are
+//  hidden so the result differs from all of them. The search starts with the root path weight
+//  so the weight of the result is summed up in the same order as if it were searched from the very beginning
+bool KShortestPathsAlgorithm::FindSpurPath(const Graph &G, const vector<PathInfo> &paths, size_t spurIndex, unsigned int worker, PathInfo &result)
+{
+	const PathInfo &last = paths.back();
+	SpurSearch &search = m_Workers[worker];
+
+	search.m_BannedTargets.resize(0);
+	for (auto it = paths.begin(); it != paths.end(); ++it)
+		if (it->m_Vertices.size() > spurIndex + 1 &&
+			equal(last.m_Vertices.begin(), last.m_Vertices.begin() + spurIndex + 1, it->m_Vertices.begin()))
+			search.m_BannedTargets.push_back(it->m_Vertices[spurIndex + 1]);
+
+	result.m_Vertices.assign(last.m_Vertices.begin(), last.m_Vertices.begin() + spurIndex);
+	result.m_Distances.assign(last.m_Distances.begin(), last.m_Distances.begin() + spurIndex);
+	result.m_DeviationIndex = spurIndex;
+	return Search(search, G.GetAdjacencyArrays(), last.m_Vertices, spurIndex, last.m_Vertices.back(), last.m_Distances[spurIndex], result);
+}
+
+//  Spur searches of one path don't depend on each other so workers just take the next spur index
+void KShortestPathsAlgorithm::FindSpurPaths(const Graph &G, const vector<PathInfo> &paths, size_t firstSpur, atomic<size_t> &nextSpur,
+											unsigned int worker, vector<PathInfo> &candidates, vector<char> &found)
+{
+	size_t lastSpur = paths.back().m_Vertices.size() - 1;
+	for (size_t i = nextSpur++; i < lastSpur; i = nextSpur++)
+		found[i - firstSpur] = FindSpurPath(G, paths, i, worker, candidates[i - firstSpur]) ? 1 : 0;
+}
+
+vector<Path> KShortestPathsAlgorithm::GetKShortestPaths(const Graph &G, unsigned int u, unsigned int v, unsigned int k)
+{
+	vector<Path> result;
+	if (k == 0 || u >= G.GetVerticesAmount() || v >= G.GetVerticesAmount())
+		return result;
+
+	//  the only loopless path from a vertex to itself
+	if (u == v)
+	{
+		result.push_back(Path(u));
+		return result;
+	}
+
+	if (!G.GetComponents().MayReach(u, v))
+		return result;
+
+	//  Buffers keep their size between calls on graphs of the same size
+	unsigned int verticesAmount = G.GetVerticesAmount();
+	const AdjacencyArrays &arrays = G.GetAdjacencyArrays();
+	for (auto it = m_Workers.begin(); it != m_Workers.end(); ++it)
+		if (it->m_Distances.size() != verticesAmount)
+		{
+			it->m_Distances.assign(verticesAmount, DBL_MAX);
+			it->m_Predecessors.resize(verticesAmount);
+		}
+	if (m_Potentials.size() != verticesAmount)
+	{
+		m_Potentials.assign(verticesAmount, DBL_MAX);
+		m_PotentialsTouched.resize(0);
+	}
+	FindPotentials(G.GetReverseAdjacencyArrays(), u, v);
+
+	//  The first path is the spur path of u without hidden vertices and edges
+	vector<PathInfo> paths(1);
+	vector<unsigned int> start(1, u);
+	paths[0].m_DeviationIndex = 0;
+	m_Workers[0].m_BannedTargets.resize(0);
+	if (!Search(m_Workers[0], arrays, start, 0, v, 0.0, paths[0]))
+		return result;
+
+	//  Threads live during the whole search, the spur searches of every path are a round of the pool
+	vector<PathInfo> candidates, spurPaths;
+	vector<char> found;
+	size_t firstSpur = 0;
+	atomic<size_t> nextSpur(0);
+	auto work = [&](unsigned int worker)
+	{
+		FindSpurPaths(G, paths, firstSpur, nextSpur, worker, spurPaths, found);
+	};
+
+	WorkerPool pool(m_Workers.size());
+	while (paths.size() < k)
+	{
+		//  Candidates are kept between rounds so the vector is sized before the round starts
+		firstSpur = paths.back().m_DeviationIndex;
+		size_t spursAmount = paths.back().m_Vertices.size() - 1 - firstSpur;
+		spurPaths.resize(spursAmount);
+		found.assign(spursAmount, 0);
+		nextSpur = firstSpur;
+		pool.Run(work);
+
+		//  Spur paths of different found paths can be the same so they are checked before adding
+		for (size_t i = 0; i < spursAmount; ++i)
+		{
+			if (!found[i])
+				continue;
+
+			bool bDuplicate = false;
+			for (auto it = candidates.begin(); it != candidates.end() && !bDuplicate; ++it)
+				bDuplicate = it->m_Vertices == spurPaths[i].m_Vertices;
+			if (!bDuplicate)
+				candidates.push_back(spurPaths[i]);
+		}
+
+		if (candidates.empty())
+			break;
+
+		//  The best candidate becomes the next path. The first of equal ones is taken so the result doesn't depend on threads
+		size_t best = 0;
+		for (size_t i = 1; i < candidates.size(); ++i)
+			if (candidates[i].m_Distances.back() < candidates[best].m_Distances.back())
+				best = i;
+		paths.push_back(candidates[best]);
+		candidates.erase(candidates.begin() + best);
+	}
+
+	for (auto it = paths.begin(); it != paths.end(); ++it)
+		result.push_back(Path(list<unsigned int>(it->m_Vertices.begin(), it->m_Vertices.end()), it->m_Distances.back()));
+	return result;
+}
@@ -0,0 +1,93 @@
+///  Contains the k shortest loopless paths algorithm declaration
+
+#ifndef K_SHORTEST_PATHS_H__
+#define K_SHORTEST_PATHS_H__
+
+#include "Graph.h"
+#include <atomic>
+
+using std::atomic;
+
+//  This class implements Yen's algorithm of the k shortest loopless paths search.
+
+//  The i-th path is searched as the best deviation from the (i-1)-th path. For each vertex of the
+//  previous path (the spur vertex) the shortest path from it to the end is searched while the beginning
+//  of the previous path (the root path) and the edges already used by the found paths with the same root
+//  are hidden: root vertices are never reached and those edges are skipped when the spur vertex is expanded.
+//  The Graph itself is not changed.
+
+//  Spur vertices before the deviation vertex of a path (where it left the path it was found from) are not searched again:
+//  their spur paths are the same as the ones of the previous path and are among the candidates already (Lawler's rule).
+
+//  Spur searches are A* searches. The potential of a vertex is a lower bound of its distance to the end in
+//  the Graph with hidden vertices and edges. The backward Dijkstra search from the end finds exact distances
+//  up to the radius of PotentialsRadius times the distance from the beginning to the end, all the other
+//  vertices are farther so the radius is their potential. Searches between close vertices don't traverse
+//  the whole Graph this way. If the backward search has visited the whole Graph the vertices it hasn't reached
+//  can't reach the end and spur searches skip them.
+//  The distances of a worker and the potentials are restored after use by the lists of the vertices they have touched.
+
+//  Each worker has its own search buffers. If there are several workers they are threads of a WorkerPool
+//  during the whole GetKShortestPaths call and spur searches of one path are done in parallel
+class KShortestPathsAlgorithm
+{
+private:
+	//  Potentials are exact up to this many times the distance between the ends of the paths
+	static const double PotentialsRadius;
+
+	//  A path with the distances from its first vertex to each of its vertices
+	//  (distances are needed to continue a root path with the exactly same weight)
+	//  and the index of the vertex where it deviates from the path it was found from
+	struct PathInfo
+	{
+		vector<unsigned int> m_Vertices;
+		vector<double> m_Distances;
+		size_t m_DeviationIndex;
+	};
+
+	//  Buffers of one worker. Distances are DBL_MAX between searches
+	struct SpurSearch
+	{
+		vector<double> m_Distances;
+		vector<unsigned int> m_Predecessors;
+		vector<unsigned int> m_Touched;
+		vector<unsigned int> m_Improved;
+		//  Ends of the edges going out of the spur vertex that are hidden
+		vector<unsigned int> m_BannedTargets;
+		PriorityQueue<unsigned int, double> m_Queue;
+	};
+
+	vector<SpurSearch> m_Workers;
+	//  Distances from vertices to the end of the paths found by the backward search (DBL_MAX if not found)
+	//  and the potential of vertices the search hasn't settled (DBL_MAX if it has visited the whole Graph)
+	vector<double> m_Potentials;
+	vector<unsigned int> m_PotentialsTouched;
+	double m_PotentialsBound;
+	RelaxationKernel m_Relax;
+
+	//  Find the distances to v by the Dijkstra search over the reversed edges. It stops at the radius of
+	//  PotentialsRadius times the distance from u to v
+	void FindPotentials(const AdjacencyArrays &backward, unsigned int u, unsigned int v);
+	//  Get the potential of the vertex
+	double GetPotential(unsigned int vertex) const;
+	//  A* search of the path from the spur vertex to v where the root vertices and banned edges are hidden.
+	//  The search starts with startDistance. Returns false if there is no path
+	bool Search(SpurSearch &search, const AdjacencyArrays &arrays, const vector<unsigned int> &root, size_t spurIndex,
+				unsigned int v, double startDistance, PathInfo &result);
+	//  Find the path deviating from the last path at the index spurIndex. Returns false if there is no such path
+	bool FindSpurPath(const Graph &G, const vector<PathInfo> &paths, size_t spurIndex, unsigned int worker, PathInfo &result);
+	//  Find spur paths for spur indices taken from nextSpur until there are no more of them.
+	//  Candidates are written by the spur index minus firstSpur
+	void FindSpurPaths(const Graph &G, const vector<PathInfo> &paths, size_t firstSpur, atomic<size_t> &nextSpur, unsigned int worker,
+					   vector<PathInfo> &candidates, vector<char> &found);
+public:
+	//  threadsAmount is the amount of spur searches done in parallel (1 means no additional threads)
+	explicit KShortestPathsAlgorithm(unsigned int threadsAmount = 1);
+	~KShortestPathsAlgorithm();
+
+	//  Get up to k shortest loopless paths from u to v sorted by their weights.
+	//  Returns less paths if the Graph doesn't have k different paths from u to v
+	vector<Path> GetKShortestPaths(const Graph &G, unsigned int u, unsigned int v, unsigned int k);
+};
+
+#endif
@@ -71,6 +71,8 @@ public:
 	size_t Size() const { return m_MinHeap.size(); }
 	//  Checks if the queue is empty
 	bool Empty() const { return m_MinHeap.size() == 0; }
+	//  Exchange elements with the other queue without copying them
+	void Swap(PriorityQueue &queue) { m_MinHeap.swap(queue.m_MinHeap); }
 
 	//  Changes priority of an element to the given
 	void ChangePriority(const TVal &val, const TPriority &priority);
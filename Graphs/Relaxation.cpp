@@ -0,0 +1,260 @@
+///  Contains edge relaxation kernels implementation
+#include "Relaxation.h"
+#include "Graph.h"
+#include <cstring>
+
+//  SIMD kernels are compiled only for x86 targets. Visual Studio got AVX-512 intrinsics in VS 2017,
+//  gcc and clang need the target attribute to compile intrinsics of the instruction set not enabled globally
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define GRAPHS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define GRAPHS_TARGET_AVX2
+#define GRAPHS_TARGET_AVX512
+#if _MSC_VER >= 1910
+#define GRAPHS_AVX512
+#endif
+#else
+#define GRAPHS_TARGET_AVX2 __attribute__((target("avx2")))
+#define GRAPHS_TARGET_AVX512 __attribute__((target("avx512f")))
+#define GRAPHS_AVX512
+#endif
+#endif
+
+//  Reference kernel. Other kernels must give exactly the same results
+static unsigned int RelaxScalar(const unsigned int *targets, const double *weights, unsigned int count,
+								double base, double *distances, unsigned int *improved)
+{
+	unsigned int amount = 0;
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		double candidate = base + weights[i];
+		if (candidate < distances[targets[i]])
+		{
+			distances[targets[i]] = candidate;
+			improved[amount++] = targets[i];
+		}
+	}
+	return amount;
+}
+
+#ifdef GRAPHS_X86
+//  The vector comparison is done against distances gathered before any lane of the block is written.
+//  A lane that fails it can't pass the scalar check too (distances only decrease), and lanes that pass it
+//  are checked once more in order. So several edges to the same vertex in one block are handled like in
+//  the scalar kernel
+GRAPHS_TARGET_AVX2
+static unsigned int RelaxAVX2(const unsigned int *targets, const double *weights, unsigned int count,
+							  double base, double *distances, unsigned int *improved)
+{
+	unsigned int amount = 0;
+	unsigned int i = 0;
+	__m256d vBase = _mm256_set1_pd(base);
+	//  The masked gather with all lanes on has a defined source so compilers don't warn about it
+	__m256d vAll = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i vTargets = _mm_loadu_si128(reinterpret_cast<const __m128i *>(targets + i));
+		__m256d vCandidates = _mm256_add_pd(vBase, _mm256_loadu_pd(weights + i));
+		__m256d vDistances = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), distances, vTargets, vAll, 8);
+		int mask = _mm256_movemask_pd(_mm256_cmp_pd(vCandidates, vDistances, _CMP_LT_OQ));
+		if (mask == 0)
+			continue;
+
+		double candidates[4];
+		_mm256_storeu_pd(candidates, vCandidates);
+		for (unsigned int j = 0; j < 4; ++j)
+			if ((mask & (1 << j)) && candidates[j] < distances[targets[i + j]])
+			{
+				distances[targets[i + j]] = candidates[j];
+				improved[amount++] = targets[i + j];
+			}
+	}
+	//  the tail that doesn't fill a whole vector
+	return amount + RelaxScalar(targets + i, weights + i, count - i, base, distances, improved + amount);
+}
+#endif
+
+#ifdef GRAPHS_AVX512
+//  The same as the AVX2 kernel but with 8 lanes
+GRAPHS_TARGET_AVX512
+static unsigned int RelaxAVX512(const unsigned int *targets, const double *weights, unsigned int count,
+								double base, double *distances, unsigned int *improved)
+{
+	unsigned int amount = 0;
+	unsigned int i = 0;
+	__m512d vBase = _mm512_set1_pd(base);
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i vTargets = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(targets + i));
+		__m512d vCandidates = _mm512_add_pd(vBase, _mm512_loadu_pd(weights + i));
+		__m512d vDistances = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xFF, vTargets, distances, 8);
+		unsigned int mask = _mm512_cmp_pd_mask(vCandidates, vDistances, _CMP_LT_OQ);
+		if (mask == 0)
+			continue;
+
+		double candidates[8];
+		_mm512_storeu_pd(candidates, vCandidates);
+		for (unsigned int j = 0; j < 8; ++j)
+			if ((mask & (1 << j)) && candidates[j] < distances[targets[i + j]])
+			{
+				distances[targets[i + j]] = candidates[j];
+				improved[amount++] = targets[i + j];
+			}
+	}
+	return amount + RelaxScalar(targets + i, weights + i, count - i, base, distances, improved + amount);
+}
+#endif
+
+#ifdef GRAPHS_X86
+//  Read CPUID leaf (and subleaf) to the regs array (eax, ebx, ecx, edx)
+static void ReadCPUID(int leaf, int subleaf, unsigned int regs[4])
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuidex(info, leaf, subleaf);
+	for (int i = 0; i < 4; ++i)
+		regs[i] = static_cast<unsigned int>(info[i]);
+#else
+	__asm__ __volatile__("cpuid" : "=a"(regs[0]), "=b"(regs[1]), "=c"(regs[2]), "=d"(regs[3]) : "a"(leaf), "c"(subleaf));
+#endif
+}
+
+//  Read XCR0 register to check which register states the OS saves on context switches
+static unsigned long long ReadXCR0()
+{
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	unsigned int eax, edx;
+	__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+#endif
+
+//  The instruction set must be supported both by the CPU and by the OS (it must save the wide registers)
+static RelaxationKernelType DetectRelaxationKernelType()
+{
+#ifdef GRAPHS_X86
+	unsigned int regs[4];
+	ReadCPUID(0, 0, regs);
+	if (regs[0] < 7)
+		return RELAXATION_SCALAR;
+
+	ReadCPUID(1, 0, regs);
+	bool bOSXSave = (regs[2] & (1u << 27)) != 0;
+	bool bAVX = (regs[2] & (1u << 28)) != 0;
+	if (!bOSXSave || !bAVX)
+		return RELAXATION_SCALAR;
+
+	unsigned long long xcr0 = ReadXCR0();
+	//  SSE and AVX states
+	if ((xcr0 & 0x6) != 0x6)
+		return RELAXATION_SCALAR;
+
+	ReadCPUID(7, 0, regs);
+	bool bAVX2 = (regs[1] & (1u << 5)) != 0;
+	bool bAVX512F = (regs[1] & (1u << 16)) != 0;
+#ifdef GRAPHS_AVX512
+	//  opmask and upper ZMM states
+	if (bAVX512F && (xcr0 & 0xE6) == 0xE6)
+		return RELAXATION_AVX512;
+#else
+	(void)bAVX512F;
+#endif
+	if (bAVX2)
+		return RELAXATION_AVX2;
+#endif
+	return RELAXATION_SCALAR;
+}
+
+bool IsRelaxationKernelSupported(RelaxationKernelType type)
+{
+	return type <= GetBestRelaxationKernelType();
+}
+
+RelaxationKernelType GetBestRelaxationKernelType()
+{
+	//  a function-level static is initialized only once
+	static const RelaxationKernelType bestType = DetectRelaxationKernelType();
+	return bestType;
+}
+
+RelaxationKernel GetRelaxationKernel(RelaxationKernelType type)
+{
+	if (!IsRelaxationKernelSupported(type))
+		return RelaxScalar;
+
+	switch (type)
+	{
+#ifdef GRAPHS_X86
+	case RELAXATION_AVX2:
+		return RelaxAVX2;
+#endif
+#ifdef GRAPHS_AVX512
+	case RELAXATION_AVX512:
+		return RelaxAVX512;
+#endif
+	default:
+		return RelaxScalar;
+	}
+}
+
+const char *GetRelaxationKernelName(RelaxationKernelType type)
+{
+	switch (type)
+	{
+	case RELAXATION_AVX2:
+		return "AVX2";
+	case RELAXATION_AVX512:
+		return "AVX-512";
+	default:
+		return "scalar";
+	}
+}
+
+//  Distances are random but some of them are equal to candidates or DBL_MAX so every branch of the kernels is checked.
+//  Kernels write only distances of targets so only they are refilled and compared for every vertex
+bool ValidateRelaxationKernel(const Graph &G, RelaxationKernelType type)
+{
+	const AdjacencyArrays &arrays = G.GetAdjacencyArrays();
+	RelaxationKernel kernel = GetRelaxationKernel(type);
+	unsigned int verticesAmount = G.GetVerticesAmount();
+	vector<double> expectedDistances(verticesAmount, DBL_MAX), distances(verticesAmount, DBL_MAX);
+	vector<unsigned int> expectedImproved, improved;
+
+	for (unsigned int v = 0; v < verticesAmount; ++v)
+	{
+		unsigned int degree = arrays.GetDegree(v);
+		if (degree == 0)
+			continue;
+
+		const unsigned int *targets = arrays.GetTargets(v);
+		const double *weights = arrays.GetWeights(v);
+		double base = GenerateRandomDouble(0.0, 10.0);
+		for (unsigned int i = 0; i < degree; ++i)
+		{
+			double r = GenerateRandomDouble(0.0, 1.0);
+			expectedDistances[targets[i]] = r < 0.25 ? DBL_MAX : GenerateRandomDouble(0.0, 20.0);
+		}
+		for (unsigned int i = 0; i < degree; i += 3)
+			expectedDistances[targets[i]] = base + weights[i];
+		for (unsigned int i = 0; i < degree; ++i)
+			distances[targets[i]] = expectedDistances[targets[i]];
+
+		expectedImproved.resize(degree);
+		improved.resize(degree);
+		unsigned int expectedAmount = RelaxScalar(targets, weights, degree, base, &expectedDistances[0], &expectedImproved[0]);
+		unsigned int amount = kernel(targets, weights, degree, base, &distances[0], &improved[0]);
+
+		if (amount != expectedAmount || memcmp(&improved[0], &expectedImproved[0], amount * sizeof(unsigned int)) != 0)
+			return false;
+		for (unsigned int i = 0; i < degree; ++i)
+			if (memcmp(&distances[targets[i]], &expectedDistances[targets[i]], sizeof(double)) != 0)
+				return false;
+	}
+
+	return true;
+}
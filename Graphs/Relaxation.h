@@ -0,0 +1,38 @@
+///  Contains edge relaxation kernels used by the Dijkstra algorithm
+
+#ifndef RELAXATION_H__
+#define RELAXATION_H__
+
+class Graph;
+
+//  Edge relaxation kernel. It relaxes count edges going out of a vertex with the distance base.
+//  Edge i leads to the vertex targets[i] and has the weight weights[i].
+//  If base + weights[i] is less than distances[targets[i]] the distance is updated and targets[i]
+//  is appended to the improved array (it must have room for count elements).
+//  Returns the amount of improved vertices.
+//  All kernels give bit-exactly the same results as the scalar one (the same distances and the same improved
+//  vertices in the same order) because candidates are computed with a single IEEE addition in every kernel
+typedef unsigned int (*RelaxationKernel)(const unsigned int *targets, const double *weights, unsigned int count,
+										 double base, double *distances, unsigned int *improved);
+
+//  Available kernel types. Types are ordered from the slowest to the fastest one
+enum RelaxationKernelType
+{
+	RELAXATION_SCALAR,
+	RELAXATION_AVX2,
+	RELAXATION_AVX512
+};
+
+//  Check if the kernel can be used on this CPU (and if it is compiled in at all)
+bool IsRelaxationKernelSupported(RelaxationKernelType type);
+//  Get the fastest kernel type supported by this CPU. CPU features are detected only once
+RelaxationKernelType GetBestRelaxationKernelType();
+//  Get the kernel of the given type. Returns the scalar kernel if the type is not supported
+RelaxationKernel GetRelaxationKernel(RelaxationKernelType type);
+//  Get the kernel name (for logging)
+const char *GetRelaxationKernelName(RelaxationKernelType type);
+//  Run the kernel and the scalar kernel over every adjacency list of the Graph with the same random
+//  distances and check that the results are bit-exactly the same
+bool ValidateRelaxationKernel(const Graph &G, RelaxationKernelType type);
+
+#endif
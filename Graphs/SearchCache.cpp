@@ -0,0 +1,110 @@
+///  Contains the shortest path search cache implementation
+#include "SearchCache.h"
+
+SearchCache::SearchCache() : m_MemoryLimit(0), m_MemoryUsage(0)
+{
+	for (int i = 0; i < 3; ++i)
+		m_Queries[i] = 0;
+}
+
+SearchCache::~SearchCache()
+{
+}
+
+void SearchCache::Remove(list<Tree>::iterator it)
+{
+	m_MemoryUsage -= it->m_MemoryUsage;
+	m_Sources.erase(it->m_Source);
+	m_Trees.erase(it);
+}
+
+void SearchCache::SetMemoryLimit(size_t bytes)
+{
+	m_MemoryLimit = bytes;
+	if (m_MemoryLimit == 0)
+		Clear();
+	else
+		while (m_MemoryUsage > m_MemoryLimit && m_Trees.size() > 1)
+			Remove(--m_Trees.end());
+}
+
+size_t SearchCache::GetMemoryLimit() const
+{
+	return m_MemoryLimit;
+}
+
+bool SearchCache::IsEnabled() const
+{
+	return m_MemoryLimit > 0;
+}
+
+void SearchCache::Clear()
+{
+	m_Trees.clear();
+	m_Sources.clear();
+	m_MemoryUsage = 0;
+}
+
+SearchCache::Tree *SearchCache::Find(unsigned int source, unsigned long long version)
+{
+	auto found = m_Sources.find(source);
+	if (found == m_Sources.end())
+		return NULL;
+
+	if (found->second->m_Version != version)
+	{
+		Remove(found->second);
+		return NULL;
+	}
+
+	//  splice doesn't invalidate iterators so the index stays valid
+	m_Trees.splice(m_Trees.begin(), m_Trees, found->second);
+	return &m_Trees.front();
+}
+
+SearchCache::Tree &SearchCache::Add(unsigned int source, unsigned long long version)
+{
+	auto found = m_Sources.find(source);
+	if (found != m_Sources.end())
+		Remove(found->second);
+
+	m_Trees.push_front(Tree());
+	Tree &tree = m_Trees.front();
+	tree.m_Version = version;
+	tree.m_Source = source;
+	tree.m_MemoryUsage = 0;
+	m_Sources[source] = m_Trees.begin();
+	return tree;
+}
+
+void SearchCache::Update(Tree &tree)
+{
+	size_t memoryUsage = sizeof(Tree) + tree.m_Settled.capacity() * sizeof(unsigned int) + tree.m_SettledFlags.capacity() +
+		tree.m_Queue.Size() * sizeof(PriorityQueueElement<unsigned int, double>) + tree.m_Distances.capacity() * sizeof(double) +
+		tree.m_Predecessors.capacity() * sizeof(unsigned int);
+	m_MemoryUsage += memoryUsage - tree.m_MemoryUsage;
+	tree.m_MemoryUsage = memoryUsage;
+
+	while (m_MemoryUsage > m_MemoryLimit && m_Trees.size() > 1 && &m_Trees.back() != &tree)
+		Remove(--m_Trees.end());
+}
+
+void SearchCache::CountQuery(CachedQueryType type)
+{
+	++m_Queries[type];
+}
+
+size_t SearchCache::GetQueriesAmount(CachedQueryType type) const
+{
+	return m_Queries[type];
+}
+
+size_t SearchCache::GetTreesAmount() const
+{
+	return m_Trees.size();
+}
+
+size_t SearchCache::GetMemoryUsage() const
+{
+	return m_MemoryUsage;
+}
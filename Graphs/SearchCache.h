@@ -0,0 +1,95 @@
+///  Contains the shortest path search cache declaration
+
+#ifndef SEARCH_CACHE_H__
+#define SEARCH_CACHE_H__
+
+#include "PriorityQueue.h"
+#include <list>
+#include <map>
+#include <vector>
+
+using std::list;
+using std::map;
+using std::vector;
+
+//  Kinds of queries answered with the cache
+enum CachedQueryType
+{
+	//  The target was already settled, the answer is read from the tree
+	CACHED_QUERY_HIT,
+	//  The paused search of the source went on until the target was settled
+	CACHED_QUERY_RESUMED,
+	//  There was no tree of the source, a new search was started
+	CACHED_QUERY_STARTED
+};
+
+//  This class keeps Dijkstra searches of ShortestPathAlgorithm (one per source) between queries.
+
+//  A search stops as soon as its target is settled, the rest of its state (the queue and the tentative
+//  distances) is kept as well. A later query from the same source either finds its target settled already
+//  or resumes the paused search. A search whose queue is empty is complete: it has the whole shortest path tree.
+
+//  Trees are bound to the version of the Graph they were built on (see Graph::GetVersion) so any edge change
+//  makes them stale. Stale trees are dropped when they are found. When the memory limit is exceeded the least recently
+//  used trees are dropped, the tree of the last query is always kept (so the limit can be exceeded by one tree)
+class SearchCache
+{
+public:
+	//  The state of a search from m_Source. It is swapped with the sets of ShortestPathAlgorithm to go on with the search
+	struct Tree
+	{
+		unsigned long long m_Version;
+		unsigned int m_Source;
+		//  Settled vertices in the order they were settled and m_SettledFlags[v] != 0 if v is settled
+		vector<unsigned int> m_Settled;
+		vector<char> m_SettledFlags;
+		PriorityQueue<unsigned int, double> m_Queue;
+		//  Distances are final for settled vertices and tentative for others
+		vector<double> m_Distances;
+		vector<unsigned int> m_Predecessors;
+		size_t m_MemoryUsage;
+
+		//  Check if the search is complete (all the vertices reachable from the source are settled)
+		bool IsComplete() const { return m_Queue.Empty(); }
+		//  Check if the vertex is settled
+		bool IsSettled(unsigned int v) const { return m_SettledFlags[v] != 0; }
+	};
+private:
+	size_t m_MemoryLimit;
+	size_t m_MemoryUsage;
+	//  The most recently used tree is the first one
+	list<Tree> m_Trees;
+	map<unsigned int, list<Tree>::iterator> m_Sources;
+	size_t m_Queries[3];
+
+	//  Drop the tree
+	void Remove(list<Tree>::iterator it);
+public:
+	SearchCache();
+	~SearchCache();
+
+	//  Set the memory limit in bytes. 0 disables the cache (it is disabled by default)
+	void SetMemoryLimit(size_t bytes);
+	size_t GetMemoryLimit() const;
+	bool IsEnabled() const;
+	//  Drop all the trees
+	void Clear();
+
+	//  Find the tree of the source built on the given version of the Graph. A tree of another version is dropped.
+	//  The found tree becomes the most recently used one. Returns NULL if there is no tree
+	Tree *Find(unsigned int source, unsigned long long version);
+	//  Add an empty tree of the source as the most recently used one
+	Tree &Add(unsigned int source, unsigned long long version);
+	//  Count the memory of the tree after its search went on and drop the least recently used trees
+	//  while the limit is exceeded
+	void Update(Tree &tree);
+
+	//  Statistics
+	void CountQuery(CachedQueryType type);
+	size_t GetQueriesAmount(CachedQueryType type) const;
+	size_t GetTreesAmount() const;
+	//  Get the memory used by the trees in bytes
+	size_t GetMemoryUsage() const;
+};
+
+#endif
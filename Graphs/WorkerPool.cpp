@@ -0,0 +1,71 @@
+///  Contains the worker pool implementation
+#include "WorkerPool.h"
+
+using std::unique_lock;
+
+WorkerPool::WorkerPool(unsigned int threadsAmount) : m_pWork(NULL), m_Round(0), m_Busy(0), m_bStop(false)
+{
+	for (unsigned int worker = 1; worker < threadsAmount; ++worker)
+		m_Helpers.push_back(thread(&WorkerPool::HelperLoop, this, worker));
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		unique_lock<mutex> lock(m_Mutex);
+		m_bStop = true;
+	}
+	m_RoundStarted.notify_all();
+	for (auto it = m_Helpers.begin(); it != m_Helpers.end(); ++it)
+		it->join();
+}
+
+//  A helper remembers the last round it has done so it neither misses a round nor does one twice
+void WorkerPool::HelperLoop(unsigned int worker)
+{
+	unsigned int seen = 0;
+	while (true)
+	{
+		const function<void(unsigned int)> *pWork;
+		{
+			unique_lock<mutex> lock(m_Mutex);
+			while (m_Round == seen && !m_bStop)
+				m_RoundStarted.wait(lock);
+			if (m_bStop)
+				return;
+			seen = m_Round;
+			pWork = m_pWork;
+		}
+		(*pWork)(worker);
+		unique_lock<mutex> lock(m_Mutex);
+		if (--m_Busy == 0)
+			m_RoundFinished.notify_one();
+	}
+}
+
+unsigned int WorkerPool::GetThreadsAmount() const
+{
+	return m_Helpers.size() + 1;
+}
+
+void WorkerPool::Run(const function<void(unsigned int)> &work)
+{
+	if (m_Helpers.empty())
+	{
+		work(0);
+		return;
+	}
+
+	{
+		unique_lock<mutex> lock(m_Mutex);
+		m_pWork = &work;
+		++m_Round;
+		m_Busy = m_Helpers.size();
+	}
+	m_RoundStarted.notify_all();
+	work(0);
+
+	unique_lock<mutex> lock(m_Mutex);
+	while (m_Busy > 0)
+		m_RoundFinished.wait(lock);
+}
@@ -0,0 +1,53 @@
+///  Contains the worker pool declaration
+
+#ifndef WORKER_POOL_H__
+#define WORKER_POOL_H__
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using std::condition_variable;
+using std::function;
+using std::mutex;
+using std::thread;
+using std::vector;
+
+//  This class keeps threads between rounds of parallel work. It is used by algorithms that do many short
+//  parallel steps (a batch of hub searches, the spur searches of one path) so threads are not started for each step.
+
+//  Run calls the work once for every worker number: 0 in the calling thread and the others in the helper threads.
+//  It returns when all of them are done. Helper threads wait for the next round and live until the pool is destroyed
+class WorkerPool
+{
+private:
+	vector<thread> m_Helpers;
+	mutex m_Mutex;
+	condition_variable m_RoundStarted;
+	condition_variable m_RoundFinished;
+	//  The work of the current round, the number of the round and the amount of helpers still doing it
+	const function<void(unsigned int)> *m_pWork;
+	unsigned int m_Round;
+	unsigned int m_Busy;
+	bool m_bStop;
+
+	//  Threads refer to the pool so it can't be copied
+	WorkerPool(const WorkerPool &pool);
+	WorkerPool &operator=(const WorkerPool &pool);
+
+	//  Do the work of every round with the given worker number until the pool is destroyed
+	void HelperLoop(unsigned int worker);
+public:
+	//  Start threadsAmount - 1 helper threads (0 is the same as 1, then Run just calls the work)
+	explicit WorkerPool(unsigned int threadsAmount);
+	~WorkerPool();
+
+	//  Get the amount of workers including the calling thread
+	unsigned int GetThreadsAmount() const;
+	//  Call work(worker) for every worker in [0, GetThreadsAmount()) and wait until all the calls are done
+	void Run(const function<void(unsigned int)> &work);
+};
+
+#endif
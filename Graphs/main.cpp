@@ -1,5 +1,12 @@
 //  Example of using Graph library
+#include "CompressedAdjacency.h"
 #include "Graph.h"
+#include "HubLabels.h"
+#include "KShortestPaths.h"
+#include <cstdio>
+
+//  Compare adjacency formats: memory per edge against the time of AverageShortestPath from several vertices
+static void BenchmarkAdjacency(const Graph &G, unsigned int sources);
 
 int main()
 {
@@ -13,5 +20,68 @@ int main()
 	
 	double average = spa.AverageShortestPath(G, 0);
 
+	//  Alternative routes: 10 best loopless paths from 0 to 49, spur searches in 4 threads
+	KShortestPathsAlgorithm kspa(4);
+	vector<Path> routes = kspa.GetKShortestPaths(G, 0, 49, 10);
+
+	//  Distance index: labels are built once, saved and mapped back, queries don't traverse the Graph
+	HubLabels labels;
+	labels.Build(G, 4);
+	if (labels.Save("labels.bin") && labels.Load("labels.bin"))
+		printf("Hub labels: %.1f hubs per vertex (max %u), %u bytes, distance 0-49 is %f\n", labels.GetAverageLabelSize(),
+			labels.GetMaxLabelSize(), static_cast<unsigned int>(labels.GetMemoryUsage()), labels.GetShortestPathLength(0, 49));
+
+	//  Changing a weight of an undirected Graph changes both directions of the edge so rebuilt labels stay exact
+	if (!G.GetNodeEdges(0).empty())
+	{
+		G.SetEdgeValue(0, G.GetNodeEdges(0).front().GetEndVertexNumber(), 0.5);
+		labels.Build(G, 4);
+		printf("Hub labels after an edge change: validation %s\n", labels.Validate(G, 1000) ? "passed" : "FAILED");
+	}
+
+	//  Repeated queries from the same sources: searches are kept in 16 MB and resumed instead of restarted
+	ShortestPathAlgorithm cachedSpa;
+	cachedSpa.SetCacheLimit(16 << 20);
+	for (unsigned int i = 0; i < 1000; ++i)
+		cachedSpa.GetShortestPathLength(G, i % 5, rand() % G.GetVerticesAmount());
+	const SearchCache &cache = cachedSpa.GetCache();
+	printf("Search cache: %u hits, %u resumed, %u started searches\n", static_cast<unsigned int>(cache.GetQueriesAmount(CACHED_QUERY_HIT)),
+		static_cast<unsigned int>(cache.GetQueriesAmount(CACHED_QUERY_RESUMED)), static_cast<unsigned int>(cache.GetQueriesAmount(CACHED_QUERY_STARTED)));
+
+	//  Check that the vectorized relaxation selected for this CPU gives the same results as the scalar one
+	RelaxationKernelType kernelType = spa.GetRelaxationKernelType();
+	bool bValid = ValidateRelaxationKernel(G, kernelType);
+	printf("Relaxation kernel: %s, validation %s\n", GetRelaxationKernelName(kernelType), bValid ? "passed" : "FAILED");
+
+	Graph big(3000, 0.05, 1.0, 10.0);
+	BenchmarkAdjacency(big, 20);
+
 	return 0;
-}
\ No newline at end of file
+}
+
+static void BenchmarkAdjacency(const Graph &G, unsigned int sources)
+{
+	ShortestPathAlgorithm spa;
+	double edgesAmount = G.GetEdgesAmount() > 0 ? static_cast<double>(G.GetEdgesAmount()) : 1.0;
+	//  a list node keeps an Edge and two pointers (the heap overhead is not counted)
+	double listBytes = G.GetEdgesAmount() * (sizeof(Edge) + 2 * sizeof(void *)) + G.GetVerticesAmount() * sizeof(list<Edge>);
+
+	clock_t start = clock();
+	for (unsigned int u = 0; u < sources; ++u)
+		spa.AverageShortestPath(G, u);
+	double arraysTime = static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+	printf("%-22s %8.2f bytes/edge\n", "list<Edge>", listBytes / edgesAmount);
+	printf("%-22s %8.2f bytes/edge %8.3f s\n", "arrays", G.GetAdjacencyArrays().GetMemoryUsage() / edgesAmount, arraysTime);
+
+	const CompressedWeights types[] = { COMPRESSED_WEIGHTS_DOUBLE, COMPRESSED_WEIGHTS_FLOAT, COMPRESSED_WEIGHTS_QUANTIZED };
+	const char *names[] = { "compressed (double)", "compressed (float)", "compressed (quantized)" };
+	for (int i = 0; i < 3; ++i)
+	{
+		CompressedAdjacency adjacency(G, types[i]);
+		start = clock();
+		for (unsigned int u = 0; u < sources; ++u)
+			spa.AverageShortestPath(adjacency, u);
+		double time = static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+		printf("%-22s %8.2f bytes/edge %8.3f s\n", names[i], adjacency.GetMemoryUsage() / edgesAmount, time);
+	}
+}